@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <vector>
+
+// host cpu placement for the core worker threads and the cycle thread
+class Affinity {
+public:
+  struct Placement {
+    std::vector<int> core_cpus; // host cpu per simulated core, -1 = unpinned
+    int cycle_cpu = -1;
+  };
+
+  // mode is "none", "auto" or a comma separated list of host cpus
+  static Placement plan(const std::string &mode, size_t num_cores);
+  static bool pin_thread(std::thread::native_handle_type thread, int cpu);
+
+private:
+  // static class - prevent instantiation
+  Affinity() = delete;
+
+  static std::vector<int> allowed_cpus();
+  static std::vector<int> spread_order(const std::vector<int> &cpus);
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// background thread doing all file output for the emulator
+// callers hand over pre-formatted buffers through a lock-free queue and
+// return immediately, the writer batches whatever has queued up into one
+// pwritev per run of adjacent buffers
+class AsyncWriter {
+public:
+  AsyncWriter();
+  // writes everything still queued, then closes the files it opened
+  ~AsyncWriter();
+
+  AsyncWriter(const AsyncWriter &) = delete;
+  AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+  // opens a file for the writer to own, returns its descriptor
+  int open(const std::string &filename, bool truncate);
+
+  // writes data at offset, offsets are reserved by the caller
+  void write_at(int fd, uint64_t offset, std::string data);
+  // replaces the whole contents of the file with data
+  void replace(int fd, std::string data);
+
+  // waits until everything queued so far is written
+  void drain();
+  // drain, then sync every file to disk
+  void flush();
+
+private:
+  struct Request {
+    Request *next;
+    int fd;
+    uint64_t offset;
+    bool truncate;
+    std::string data;
+  };
+
+  // requests are pushed onto a lock-free stack, the writer takes the whole
+  // stack at once and reverses it back into queue order
+  std::atomic<Request *> pending_ = nullptr;
+  std::atomic<uint64_t> queued_ = 0;
+  std::atomic<uint64_t> written_ = 0;
+  std::atomic<bool> stopping_ = false;
+
+  std::mutex files_mutex_;
+  std::vector<int> files_;
+
+  std::jthread thread_;
+
+  void push(Request *request);
+  void run();
+  void write_batch(const std::vector<Request *> &requests);
+};
@@ -1,20 +1,63 @@
 #pragma once
 #include "Process.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// plain totals, summed across cores on read
+struct CoreStats {
+  uint64_t active_ticks = 0;
+  uint64_t idle_ticks = 0;
+  uint64_t instructions = 0;
+  uint64_t preemptions = 0;
+  uint64_t sleeps = 0;
+
+  CoreStats &operator+=(const CoreStats &other);
+};
 
 class CPUCore {
 public:
-  CPUCore(int id, const std::string scheduler, const int delay_per_exec);
+  CPUCore(int id, const std::string scheduler, const int delay_per_exec,
+          const bool is_virtual_delay = false,
+          const bool is_fusion_enabled = false);
   Process *tick(MemoryManager *memory_manager);
+  Process *run(MemoryManager *memory_manager, uint32_t max_ticks);
+  void idle(uint64_t ticks);
   const bool is_idle() const;
   const Process *get_current_process() const;
   Process *get_current_process();
   void set_current_process(Process *process);
+  const CoreStats get_stats() const;
+  uint64_t take_virtual_delay();
 
 private:
+  // counters owned by this core, on their own cache line so cores ticking in
+  // parallel never share one
+  // only the thread running the core writes them, readers load relaxed
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> active_ticks = 0;
+    std::atomic<uint64_t> idle_ticks = 0;
+    std::atomic<uint64_t> instructions = 0;
+    std::atomic<uint64_t> preemptions = 0;
+    std::atomic<uint64_t> sleeps = 0;
+  };
+
   int id_;
   Process *current_process_ = nullptr;
   const std::string scheduler_ = "fcfs";
+  const bool is_preemptive_;
   const int delay_per_exec_;
 
+  // virtual delay mode charges delay-per-exec here instead of spinning,
+  // the cycle thread collects it after every cycle to pace itself
+  const bool is_virtual_delay_;
+  uint64_t virtual_delay_ = 0;
+  // runs superinstructions as one dispatch when the tick budget allows
+  const bool is_fusion_enabled_;
+  std::unique_ptr<Counters> counters_ = std::make_unique<Counters>();
+
+  Process *step(MemoryManager *memory_manager, uint32_t max_ticks,
+               uint32_t &ticks);
   void busy_wait(int cycles);
+  static void increment(std::atomic<uint64_t> &counter, uint64_t value = 1);
 };
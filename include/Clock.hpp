@@ -0,0 +1,22 @@
+#pragma once
+#include <atomic>
+#include <ctime>
+#include <string>
+
+// second resolution wall clock for log and process timestamps
+// now() is a relaxed load of the time the cycle thread refreshes once per
+// cycle and the shell once per command, so stamping a log never reaches into
+// libc, formatting happens only when a timestamp is displayed
+class Clock {
+public:
+  static std::time_t now() { return now_.load(std::memory_order_relaxed); }
+  static void refresh();
+  // MM/DD/YYYY HH:MM:SSAM in local time, safe from any thread
+  static std::string format(std::time_t time);
+
+private:
+  // static class - prevent instantiation
+  Clock() = delete;
+
+  static std::atomic<std::time_t> now_;
+};
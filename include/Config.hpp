@@ -17,6 +17,14 @@ public:
   uint32_t get_min_ins() const;
   uint32_t get_max_ins() const;
   uint32_t get_delay_per_exec() const;
+  std::string get_execution_mode() const;
+  std::string get_delay_mode() const;
+  uint64_t get_random_seed() const;
+  std::string get_cpu_affinity() const;
+  std::string get_program_generator() const;
+  std::string get_fuse_instructions() const;
+  uint32_t get_log_buffer_size() const;
+  std::string get_log_spill() const;
 
   uint32_t get_max_overall_mem() const;
   uint32_t get_mem_per_frame() const;
@@ -40,6 +48,14 @@ private:
   uint32_t min_ins_;
   uint32_t max_ins_;
   uint32_t delay_per_exec_;
+  std::string execution_mode_;
+  std::string delay_mode_;
+  uint64_t random_seed_;
+  std::string cpu_affinity_;
+  std::string program_generator_;
+  std::string fuse_instructions_;
+  uint32_t log_buffer_size_;
+  std::string log_spill_;
 
   uint32_t max_overall_mem_;
   uint32_t mem_per_frame_;
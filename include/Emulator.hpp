@@ -1,10 +1,20 @@
 #pragma once
+#include "Affinity.hpp"
+#include "AsyncWriter.hpp"
 #include "CPUCore.hpp"
 #include "CommandParser.hpp"
 #include "Config.hpp"
+#include "LogSegment.hpp"
 #include "MemoryManager.hpp"
 #include "Process.hpp"
+#include "Random.hpp"
+#include "StatsSnapshot.hpp"
+#include "TimingWheel.hpp"
+#include "instructions/ProgramCache.hpp"
 #include "schedulers/IScheduler.hpp"
+#include <atomic>
+#include <barrier>
+#include <chrono>
 #include <condition_variable>
 #include <memory>
 #include <string>
@@ -12,10 +22,21 @@
 #include <unordered_map>
 #include <vector>
 
+struct BenchmarkOptions {
+  std::string config_file = "config.txt";
+  uint64_t cycles = 0;  // 0 = no cycle limit
+  double seconds = 0.0; // 0 = no time limit
+  uint64_t seed = 0;     // 0 = use the config seed
+  uint64_t micro_instructions = 0; // > 0 = single core instruction benchmark
+};
+
 class Emulator {
 public:
   Emulator();
+  ~Emulator();
   bool process_input(const std::string &input);
+  void run_benchmark(const BenchmarkOptions &options);
+  void run_instruction_benchmark(const BenchmarkOptions &options);
 
 private:
   CommandParser parser_;
@@ -23,12 +44,15 @@ private:
   bool is_initialized_ = false;
 
   // process management
+  // processes_ is shared with the shell thread, guarded by processes_mutex_
+  std::mutex processes_mutex_;
   std::unordered_map<std::string, std::unique_ptr<Process>> processes_;
   std::vector<Process *> terminated_processes_;
-  std::vector<Process *> sleeping_processes_;
+  TimingWheel sleeping_processes_;
   Process *current_process_ = nullptr;
 
-  int cpu_cycles_ = 0;
+  std::atomic<uint64_t> cpu_cycles_ = 0;
+  uint64_t max_cycles_ = 0; // 0 = run until stopped
 
   std::vector<CPUCore> cores_;
 
@@ -38,15 +62,46 @@ private:
   // cycle mutex
   std::mutex mtx_;
   std::condition_variable cv_;
-  bool cycle_finished_ = false;
+  bool cycle_thread_done_ = false;
+
+  // parked cycle thread, woken by new processes or scheduler-start
+  std::condition_variable_any wake_cv_;
+  std::vector<Process *> pending_processes_;
+
+  // stats published at the end of every cycle for monitoring commands
+  // the two owned snapshots are recycled once no reader holds them
+  std::atomic<std::shared_ptr<const StatsSnapshot>> stats_snapshot_;
+  std::shared_ptr<StatsSnapshot> published_snapshot_;
+  std::shared_ptr<StatsSnapshot> spare_snapshot_;
   std::jthread cycle_thread_;
 
+  // core worker pool, one long-lived thread per core
+  // the cycle thread and every worker meet at tick_barrier_ twice per cycle:
+  // once to release the tick and once to collect the results
+  std::vector<std::jthread> core_workers_;
+  std::unique_ptr<std::barrier<>> tick_barrier_;
+  std::vector<Process *> returned_processes_;
+  Affinity::Placement placement_;
+
+  // wall clock deadline of the current cycle in virtual delay mode
+  std::chrono::steady_clock::time_point cycle_deadline_;
+
+  // simulated ticks each core runs per cycle
+  // 1 in lockstep mode, quantum-cycles in quantum mode
+  uint32_t ticks_per_cycle_ = 1;
+  std::atomic<bool> workers_stopping_ = false;
+
   std::unique_ptr<MemoryManager> memory_manager_;
 
-  // cpu stats
-  uint64_t total_cpu_ticks_ = 0;
-  uint64_t idle_cpu_ticks_ = 0;
-  uint64_t active_cpu_ticks_ = 0;
+  // all file output besides the backing store goes through the writer
+  std::unique_ptr<AsyncWriter> writer_;
+  int report_file_ = -1;
+
+  // logs pushed out of process ring buffers, only with log-spill on
+  std::unique_ptr<LogSegment> log_segment_;
+
+  // program images shared between processes running the same program
+  ProgramCache program_cache_;
 
   // cpu cycle loop
   void cycle(std::stop_token st);
@@ -54,11 +109,26 @@ private:
   // cycle helpers
   uint32_t assign_processes(uint32_t current_running_processes,
                             uint32_t max_concurrent_processes);
-  std::vector<Process *> tick_cores();
+  const std::vector<Process *> &tick_cores();
+  void core_worker(size_t core_index);
+  void start_core_workers();
+  void stop_core_workers();
   void generate_processes();
+  void load_program(Process &process, int num_instructions, RandomStream &rng);
   void
   handle_returned_processes(const std::vector<Process *> &returned_processes);
   void handle_sleeping_processes();
+  void fast_forward_idle_cycles();
+  void pace_cycle(std::stop_token st);
+  void wait_for_work(std::stop_token st);
+  bool has_work() const;
+  void submit_process(Process *process);
+  void publish_stats_snapshot();
+  CoreStats get_core_stats() const;
+
+  // setup helpers
+  void setup(const std::string &config_file);
+  void start_cycle_thread();
 
   // command handlers
   void initialize();
@@ -67,6 +137,8 @@ private:
   void screen(const std::vector<std::string> &args);
 
   // screen helpers
+  // logs shown per screen -r page
+  static constexpr uint64_t LOG_PAGE_SIZE = 50;
   void start_screen(std::vector<std::string> &args);
   void list_screens();
   void resume_screen(std::vector<std::string> &args);
@@ -75,9 +147,11 @@ private:
   void scheduler_start();
   void scheduler_stop();
   void report_util();
+  void flush();
 
   // report helper
-  void log_cpu_util_report(std::ostream &output_stream);
+  void log_cpu_util_report(std::ostream &output_stream,
+                           const StatsSnapshot &snapshot);
 
   void process_smi();
   void vmstat();
@@ -0,0 +1,36 @@
+#pragma once
+#include "AsyncWriter.hpp"
+#include "Process.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// append-only file holding log records pushed out of process ring buffers
+// every process's batches form a chain through the file, each batch pointing
+// back at the previous one, so a process only remembers its newest batch
+// appends only reserve space and queue the batch on the async writer
+class LogSegment {
+public:
+  // records per batch, ring buffers spill in whole batches
+  static constexpr uint32_t BATCH_SIZE = 64;
+
+  LogSegment(const std::string &filename, AsyncWriter &writer);
+
+  // writes a batch of records numbered from first_log, returns its offset
+  int64_t append(int64_t previous_batch, uint64_t first_log,
+                 const ProcessLog *logs, uint32_t count);
+  // records [first_log, last_log) from the chain ending at batch
+  std::vector<ProcessLog> read(int64_t batch, uint64_t first_log,
+                               uint64_t last_log);
+
+private:
+  struct BatchHeader {
+    int64_t previous_batch;
+    uint64_t first_log;
+    uint32_t count;
+  };
+
+  AsyncWriter &writer_;
+  int fd_;
+  std::atomic<int64_t> end_ = 0;
+};
@@ -13,7 +13,7 @@ struct FrameTableEntry {
   uint32_t virtual_page_number = -1;
 };
 
-enum class MemoryAccessResult { SUCCESS, ACCESS_VIOLATION, ERROR };
+enum class MemoryAccessResult : uint8_t { SUCCESS, ACCESS_VIOLATION, ERROR };
 
 class MemoryManager {
 public:
@@ -43,6 +43,8 @@ public:
   uint64_t get_paged_out_count() const;
 
 private:
+  // taken for page faults, frame allocation and stats, accesses to resident
+  // pages only pin the process's page table
   mutable std::mutex memory_mutex_;
 
   std::vector<char> physical_memory_;
@@ -63,8 +65,12 @@ private:
   uint64_t paged_in_count_ = 0;
   uint64_t paged_out_count_ = 0;
   uint64_t total_memory_usage_ = 0;
+  uint32_t used_frames_ = 0;
 
   // helpers
+  MemoryAccessResult load(int frame_number, uint32_t offset,
+                          uint16_t &out_value);
+  MemoryAccessResult store(int frame_number, uint32_t offset, uint16_t value);
   void page_fault(Process *process, uint32_t virtual_page_number);
   int get_victim_frame();
   void read_page_from_backing_store(Process *process,
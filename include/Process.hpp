@@ -1,17 +1,54 @@
 #pragma once
-#include "Utils.hpp"
+#include "Clock.hpp"
 #include "instructions/IInstruction.hpp"
+#include "instructions/InstructionStream.hpp"
+#include "instructions/Program.hpp"
+#include <array>
+#include <atomic>
+#include <ctime>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+class LogSegment;
 class MemoryManager;
 
+// defined in MemoryManager.hpp, which includes this header
+enum class MemoryAccessResult : uint8_t;
+
+// what a log record describes
+enum class LogEvent : uint8_t {
+  PRINT,          // a = text
+  PRINT_VAR,      // a = prefix text, b = suffix text, value
+  FOR,            // a = repeats, b = depth
+  READ_VARIABLE,  // a = symbol, address, value, result
+  WRITE_VARIABLE, // a = symbol, address, value, result
+  READ_ADDRESS,   // address, value, result
+  WRITE_ADDRESS   // address, value, result
+};
+
+// a log entry kept as raw operands, texts and symbols are ids into the
+// process's program, only turned into text when someone displays it
+// stamped with the wall clock second that screen -r shows rather than a cycle
+// number, which nothing displays and would grow a record from 24 to 32 bytes
 struct ProcessLog {
-  std::string timestamp = Utils::current_timestamp();
-  int core_id;
-  std::string message;
+  std::time_t time = 0;
+  uint32_t address = 0;
+  uint16_t a = 0;
+  uint16_t b = 0;
+  uint16_t value = 0;
+  int16_t core_id = -1; // -1 for memory accesses
+  LogEvent event = LogEvent::PRINT;
+  MemoryAccessResult result{}; // SUCCESS, set by memory accesses
+};
+
+// an active FOR, the body is [body_start, body_end) in the program
+struct LoopFrame {
+  uint32_t body_start = 0;
+  uint32_t body_end = 0;
+  uint32_t repeats_left = 0;
 };
 
 struct PageTableEntry {
@@ -24,9 +61,14 @@ class Process {
 public:
   enum class ProcessState { NEW, READY, RUNNING, SLEEPING, TERMINATED };
 
+  // logs kept until set_log_buffer says otherwise
+  static constexpr uint32_t DEFAULT_LOG_CAPACITY = 256;
+
   Process(const std::string &name, int total_instructions, int quantum_cycles);
   void execute_current_instruction(int cpu_core_id,
-                                   MemoryManager *memory_manager);
+                                   MemoryManager *memory_manager,
+                                   int width = 1);
+  int get_instruction_width(int max_width) const;
   const int get_id() const;
   const std::string get_name() const;
   const std::string get_created_at() const;
@@ -34,40 +76,84 @@ public:
   const int get_instruction_pointer() const;
   const ProcessState get_state() const;
   const int is_quantum_expired() const;
-  const std::vector<ProcessLog> &get_logs() const { return logs_; }
+  const int get_quantum_remaining() const;
+  // logs are numbered from 0 in the order they were written, only
+  // [get_first_log(), get_log_count()) is still kept in memory or spilled
+  uint64_t get_first_log() const;
+  uint64_t get_log_count() const;
+  std::vector<ProcessLog> get_logs(uint64_t first_log,
+                                   uint64_t last_log) const;
+  std::string format_log_message(const ProcessLog &log) const;
+  // kept logs in [first_log, last_log) as display lines, safe while the
+  // process runs
+  std::string format_logs(uint64_t first_log, uint64_t last_log) const;
+  const Program &get_program() const {
+    return stream_ ? stream_->get_program() : *program_;
+  }
   const int get_page_table_size() const;
   const PageTableEntry &get_page_table_entry(int virtual_page_number) const;
   PageTableEntry &get_page_table_entry(int virtual_page_number);
   const uint32_t get_total_memory_size() const;
   const uint32_t get_backing_store_offset() const;
   const bool get_access_violation() const;
+  const int get_sleep_ticks() const;
+  const uint32_t get_resident_pages() const;
 
-  void increment_instruction_pointer();
+  void increment_instruction_pointer(int count = 1);
   void
   set_instructions(std::vector<std::unique_ptr<IInstruction>> &&instructions);
+  void set_program(std::shared_ptr<const Program> program);
+  void set_instruction_stream(std::unique_ptr<InstructionStream> stream);
+  void set_log_buffer(uint32_t capacity, LogSegment *log_segment);
   void set_state(ProcessState state);
   void set_quantum_remaining(int quantum_cycles);
-  void decrement_quantum_remaining();
-  void decrement_sleep_ticks();
+  void decrement_quantum_remaining(int ticks = 1);
+  void wake();
   void set_page_table_size(int size);
   void set_total_memory_size(uint32_t size);
   void set_backing_store_offset(uint32_t offset);
   void set_access_violation(bool violation);
+  void add_resident_pages(int delta);
+  void clear_resident_pages();
+
+  // lets the running core translate through the page table without the
+  // memory manager lock, fails while another core evicts one of its pages
+  bool pin_page_table();
+  void unpin_page_table();
+  // for the evicting core, holding the memory manager lock, waits for the
+  // running core to unpin
+  void lock_page_table();
+  void unlock_page_table();
 
 private:
   static int next_id_;
   int id_;
   std::string name_;
-  std::string created_at_ = Utils::current_timestamp();
-  std::vector<std::unique_ptr<IInstruction>> instructions_;
-  std::unordered_map<std::string, uint32_t> symbol_table_;
-  uint32_t next_symbol_address_ = 0x40; // start at 64 bytes
+  std::time_t created_at_ = Clock::now();
+  // shared read-only image, all per-process execution state lives here
+  std::shared_ptr<const Program> program_;
+  // generated programs decoded on demand, replaces program_ when set
+  std::unique_ptr<InstructionStream> stream_;
   int total_instructions_;
+  // instructions executed so far, loop bodies count once per repeat
   int instruction_pointer_ = 0;
+  // next bytecode to execute
+  uint32_t program_counter_ = 0;
+  std::array<LoopFrame, MAX_LOOP_DEPTH> loop_stack_;
+  int loop_depth_ = 0;
   ProcessState state_;
   int quantum_remaining_;
+  // ring of the newest logs_capacity_ logs, grows until it is full
   std::vector<ProcessLog> logs_;
-  int sleep_ticks_;
+  uint32_t logs_capacity_ = DEFAULT_LOG_CAPACITY;
+  uint64_t log_count_ = 0;
+  // logs about to be overwritten are spilled here when set
+  LogSegment *log_segment_ = nullptr;
+  int64_t last_spilled_batch_ = -1;
+  // taken by the running core to append and by readers formatting, also
+  // held while a stream decodes since that grows the texts logs refer to
+  mutable std::mutex logs_mutex_;
+  int sleep_ticks_ = 0;
 
   // page table for memory management
   std::vector<PageTableEntry> page_table_;
@@ -77,15 +163,28 @@ private:
 
   bool access_violation_ = false;
 
-  // callback definitions
-  void add_log(int cpu_core_id, const std::string &message);
-  uint16_t get_variable(const std::string &var_name,
-                        MemoryManager *memory_manager);
-  void add_variable(std::pair<std::string, uint16_t> var,
-                    MemoryManager *memory_manager);
-  void add_instructions(
-      std::vector<std::unique_ptr<IInstruction>> &&new_instructions);
+  // frames currently holding this process's pages, updated by the memory
+  // manager and read by the stats snapshot without its lock
+  std::atomic<uint32_t> resident_pages_ = 0;
+
+  // pin count of the running core, plus EVICTING while another core changes
+  // the page table
+  static constexpr uint32_t EVICTING = 1u << 31;
+  std::atomic<uint32_t> page_table_state_ = 0;
+
+  // instruction operations, reached through ExecutionContext
+  friend class ExecutionContext;
+
+  void add_log(ProcessLog log);
+  void spill_logs(size_t first_slot);
+  uint16_t get_variable(uint16_t symbol, MemoryManager *memory_manager,
+                        MemoryAccessResult &out_result);
+  MemoryAccessResult add_variable(uint16_t symbol, uint16_t value,
+                                  MemoryManager *memory_manager);
+  void reuse_variable(uint16_t symbol, uint16_t value);
   void sleep(int ticks);
+  void enter_loop(uint32_t body_length, uint32_t repeats);
+  bool fetch();
   uint16_t read_from_address(uint32_t address, MemoryManager *memory_manager);
   void write_to_address(uint32_t address, uint16_t value,
                         MemoryManager *memory_manager);
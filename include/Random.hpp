@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// counter based random stream
+// the n-th value is a pure function of (key, n), so streams are cheap to
+// create, independent of each other and safe to use from any thread
+class RandomStream {
+public:
+  explicit RandomStream(uint64_t key);
+  uint64_t next();
+  uint32_t next_below(uint32_t bound);
+  uint32_t next_in_range(uint32_t min, uint32_t max);
+
+private:
+  uint64_t key_;
+  uint64_t counter_ = 0;
+};
+
+class Random {
+public:
+  // stream domains, keep generators that share an id independent
+  enum class Domain : uint64_t { PROCESS_GENERATION = 1, SCREEN = 2 };
+
+  static void set_seed(uint64_t seed);
+  static uint64_t get_seed();
+  static RandomStream stream(Domain domain, uint64_t stream_id);
+  static RandomStream stream(Domain domain, const std::string &name);
+
+private:
+  // static class - prevent instantiation
+  Random() = delete;
+
+  static uint64_t seed_;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class Process;
+
+// immutable view of the emulator published by the cycle thread at the end of
+// every cycle, monitoring commands read it without touching live state
+struct StatsSnapshot {
+  struct ProcessEntry {
+    const Process *process;
+    int core_id; // -1 = finished
+    int instruction_pointer;
+    int total_instructions;
+    uint32_t memory_used;
+  };
+
+  uint64_t cpu_cycles = 0;
+  bool is_scheduler_running = false;
+  size_t num_cores = 0;
+
+  std::vector<ProcessEntry> running_processes;
+  std::vector<ProcessEntry> finished_processes; // first few only
+  size_t finished_count = 0;
+
+  // memory stats
+  uint32_t total_memory_size = 0;
+  uint32_t used_memory_size = 0;
+  uint64_t paged_in_count = 0;
+  uint64_t paged_out_count = 0;
+
+  // cpu stats
+  uint64_t total_cpu_ticks = 0;
+  uint64_t idle_cpu_ticks = 0;
+  uint64_t active_cpu_ticks = 0;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Process;
+
+// two level timing wheel for sleeping processes
+// near slots cover the next 256 ticks one tick each, far slots cover 256
+// ticks each and cascade into the near slots as the wheel turns, so every
+// tick only touches the slot that expires on it
+class TimingWheel {
+public:
+  void schedule(Process *process, uint64_t delay);
+  const std::vector<Process *> &advance();
+  void skip(uint64_t ticks);
+  uint64_t ticks_until_next_expiry() const;
+  bool empty() const;
+
+private:
+  static constexpr uint64_t SLOT_BITS = 8;
+  static constexpr uint64_t NUM_SLOTS = 1 << SLOT_BITS;
+  static constexpr uint64_t SLOT_MASK = NUM_SLOTS - 1;
+
+  struct Timer {
+    uint64_t expires_at;
+    Process *process;
+  };
+
+  std::array<std::vector<Timer>, NUM_SLOTS> near_slots_;
+  std::array<std::vector<Timer>, NUM_SLOTS> far_slots_;
+  std::vector<Process *> expired_;
+  uint64_t current_tick_ = 0;
+  size_t size_ = 0;
+
+  void insert(const Timer &timer);
+  void cascade();
+};
@@ -1,9 +1,12 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 class Utils {
 public:
-  static std::string current_timestamp();
+  static uint64_t peak_rss_kb();
+  // text safe to place between quotes in json output
+  static std::string json_escape(const std::string &text);
 
 private:
   // static class - prevent instantiation
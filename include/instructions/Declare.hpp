@@ -5,7 +5,7 @@ class Declare : public IInstruction {
 public:
   using Variable = std::pair<std::string, uint16_t>;
   Declare(const Variable &variable);
-  void execute(InstructionContext context) override;
+  void compile(ProgramBuilder &builder) const override;
   std::unique_ptr<IInstruction> clone() override;
 
 private:
@@ -0,0 +1,60 @@
+#pragma once
+#include "Process.hpp"
+
+// what an instruction may do to the process running it
+// bound to the process, memory manager and core for a single instruction
+// and passed by reference, so executing an instruction allocates nothing and
+// every call is a direct, inlinable call into Process
+class ExecutionContext {
+public:
+  ExecutionContext(Process &process, MemoryManager *memory_manager,
+                   int cpu_core_id)
+      : process_(process), memory_manager_(memory_manager),
+        cpu_core_id_(cpu_core_id) {}
+
+  void add_log(LogEvent event, uint16_t a, uint16_t b = 0,
+               uint16_t value = 0) {
+    process_.add_log(ProcessLog{.a = a,
+                                .b = b,
+                                .value = value,
+                                .core_id = static_cast<int16_t>(cpu_core_id_),
+                                .event = event});
+  }
+
+  uint16_t get_variable(uint16_t symbol) {
+    MemoryAccessResult result;
+    return process_.get_variable(symbol, memory_manager_, result);
+  }
+
+  uint16_t get_variable(uint16_t symbol, MemoryAccessResult &out_result) {
+    return process_.get_variable(symbol, memory_manager_, out_result);
+  }
+
+  MemoryAccessResult add_variable(uint16_t symbol, uint16_t value) {
+    return process_.add_variable(symbol, value, memory_manager_);
+  }
+
+  // for superinstructions, logs a read of a value already in hand
+  void reuse_variable(uint16_t symbol, uint16_t value) {
+    process_.reuse_variable(symbol, value);
+  }
+
+  void sleep(uint8_t ticks) { process_.sleep(ticks); }
+
+  void enter_loop(uint32_t body_length, uint16_t repeats) {
+    process_.enter_loop(body_length, repeats);
+  }
+
+  uint16_t read_from_address(uint32_t address) {
+    return process_.read_from_address(address, memory_manager_);
+  }
+
+  void write_to_address(uint32_t address, uint16_t value) {
+    process_.write_to_address(address, value, memory_manager_);
+  }
+
+private:
+  Process &process_;
+  MemoryManager *memory_manager_;
+  int cpu_core_id_;
+};
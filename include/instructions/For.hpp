@@ -4,7 +4,7 @@
 class For : public IInstruction {
 public:
   For(std::vector<std::unique_ptr<IInstruction>> instructions, int repeats);
-  void execute(InstructionContext context) override;
+  void compile(ProgramBuilder &builder) const override;
   std::unique_ptr<IInstruction> clone() override;
 
 private:
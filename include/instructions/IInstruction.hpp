@@ -1,5 +1,4 @@
 #pragma once
-#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -7,21 +6,12 @@
 // forward declare to avoid circular dependency
 class Process;
 class IInstruction;
-
-struct InstructionContext {
-  std::function<void(const std::string &)> add_log;
-  std::function<uint16_t(const std::string &)> get_variable;
-  std::function<void(std::pair<std::string, uint16_t>)> add_variable;
-  std::function<void(std::vector<std::unique_ptr<IInstruction>> &&)>
-      add_instructions;
-  std::function<void(uint8_t)> sleep;
-  std::function<uint16_t(uint32_t)> read_from_address;
-  std::function<void(uint32_t, uint16_t)> write_to_address;
-};
+class ProgramBuilder;
 
 class IInstruction {
 public:
   virtual ~IInstruction() = default;
-  virtual void execute(InstructionContext context) = 0;
+  // appends this instruction's bytecode to the program being built
+  virtual void compile(ProgramBuilder &builder) const = 0;
   virtual std::unique_ptr<IInstruction> clone() = 0;
 };
@@ -7,6 +7,7 @@
 #include "instructions/Read.hpp"
 #include "instructions/Sleep.hpp"
 #include "instructions/Write.hpp"
+#include "Random.hpp"
 #include <memory>
 #include <string>
 #include <vector>
@@ -26,11 +27,16 @@ public:
   };
   static std::vector<std::unique_ptr<IInstruction>>
   create_instructions(const std::string &process_name, int num_instructions,
-                      int max_ins, int min_ins, int start_depth = 0,
-                      int max_depth = 3);
+                      int max_ins, int min_ins, RandomStream &rng,
+                      int start_depth = 0, int max_depth = 3);
+  static std::unique_ptr<IInstruction>
+  create_next_instruction(const std::string &process_name, int num_instructions,
+                          int max_ins, int min_ins, RandomStream &rng,
+                          int start_depth, int max_depth,
+                          int &curr_instructions_count);
   static std::vector<std::unique_ptr<IInstruction>>
   create_mo1_demo_instructions(const std::string &process_name,
-                               int num_instructions);
+                               int num_instructions, RandomStream &rng);
   static std::vector<std::unique_ptr<IInstruction>>
   create_instructions_from_string(const std::string &code);
   static std::vector<std::unique_ptr<IInstruction>>
@@ -46,14 +52,15 @@ private:
   static std::unique_ptr<Sleep> create_sleep(uint8_t ticks);
   static std::unique_ptr<For>
   create_for(const std::string &process_name, int num_instructions, int min_ins,
-             int max_ins, int repeats, int start_depth = 0, int max_depth = 3);
+             int max_ins, int repeats, RandomStream &rng, int start_depth = 0,
+             int max_depth = 3);
   static std::unique_ptr<Read> create_read(const std::string &var_name,
                                            uint32_t memory_address);
   static std::unique_ptr<Write> create_write(uint32_t memory_address,
                                              uint16_t value);
 
   // helpers
-  static Arithmetic::Operand random_operand();
+  static Arithmetic::Operand random_operand(RandomStream &rng);
   static std::string trim(const std::string &str);
   static uint32_t parse_addr_val(const std::string &str);
   static Arithmetic::Operand parse_operand(const std::string &str);
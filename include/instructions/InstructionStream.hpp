@@ -0,0 +1,29 @@
+#pragma once
+#include "Random.hpp"
+#include "instructions/Program.hpp"
+#include <string>
+
+// a randomly generated program kept as its generator parameters and random
+// stream, decoded one top-level instruction at a time as the process runs
+// and producing exactly what create_instructions does for the same stream
+class InstructionStream {
+public:
+  InstructionStream(const std::string &process_name, int num_instructions,
+                    int max_ins, int min_ins, const RandomStream &rng);
+
+  // replaces the current program with the next top-level instruction, a FOR
+  // comes with its whole body, false once the stream is exhausted
+  bool advance();
+  const Program &get_program() const { return builder_.get_program(); }
+
+private:
+  std::string process_name_;
+  int num_instructions_;
+  int max_ins_;
+  int min_ins_;
+  RandomStream rng_;
+  int generated_count_ = 0;
+
+  // keeps symbol addresses and texts across decoded instructions
+  ProgramBuilder builder_;
+};
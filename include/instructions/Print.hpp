@@ -4,7 +4,7 @@
 class Print : public IInstruction {
 public:
   Print(const std::string &msg);
-  void execute(InstructionContext context) override;
+  void compile(ProgramBuilder &builder) const override;
   std::unique_ptr<IInstruction> clone() override;
 
 private:
@@ -0,0 +1,112 @@
+#pragma once
+#include "instructions/IInstruction.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ExecutionContext;
+
+// operands are immediates or indices into the program's symbol and text
+// tables
+enum class Opcode : uint8_t {
+  PRINT,     // a = text
+  PRINT_VAR, // a = prefix text, b = variable, c = suffix text
+  DECLARE,   // a = variable, b = value
+  ADD,       // a = variable, b and c = operands, flags mark variables
+  SUBTRACT,  // same as ADD
+  SLEEP,     // a = ticks
+  FOR,       // a = repeats, b = depth, address = body length, body follows
+  READ,      // a = variable, address
+  WRITE      // address, a = value
+};
+
+struct Bytecode {
+  static constexpr uint8_t LHS_VARIABLE = 1 << 0;
+  static constexpr uint8_t RHS_VARIABLE = 1 << 1;
+  // superinstruction, this and the next bytecode may run as one combined
+  // operation
+  static constexpr uint8_t FUSED_WITH_NEXT = 1 << 2;
+
+  Opcode opcode;
+  uint8_t flags = 0;
+  uint16_t a = 0;
+  uint16_t b = 0;
+  uint16_t c = 0;
+  uint32_t address = 0;
+};
+
+// deepest FOR nesting a program may have
+constexpr int MAX_LOOP_DEPTH = 3;
+
+// instructions in the widest superinstruction
+constexpr int MAX_FUSED_WIDTH = 2;
+
+// a variable resolved to its virtual address when the program is built
+struct Symbol {
+  std::string name;
+  uint32_t address;
+};
+
+// a process program compiled to flat bytecode
+class Program {
+public:
+  static Program
+  compile(const std::vector<std::unique_ptr<IInstruction>> &instructions);
+
+  // runs the instruction at program_counter, or with a width of
+  // MAX_FUSED_WIDTH the superinstruction starting there
+  void execute(size_t program_counter, ExecutionContext &context,
+               int width = 1) const;
+  // instructions that can run at program_counter as one dispatch
+  int get_width(size_t program_counter, int max_width) const;
+  size_t size() const { return code_.size(); }
+  // symbol table, execution uses the resolved addresses, logs the names
+  const std::vector<Symbol> &get_symbols() const { return symbols_; }
+  const std::string &get_text(uint16_t text) const { return texts_[text]; }
+
+private:
+  friend class ProgramBuilder;
+
+  void execute_one(const Bytecode &bytecode, ExecutionContext &context) const;
+  void execute_fused(const Bytecode &first, const Bytecode &second,
+                     ExecutionContext &context) const;
+  static uint16_t arithmetic(const Bytecode &bytecode, int lhs, int rhs);
+  void fuse_superinstructions();
+  static bool is_fusable(const Bytecode &first, const Bytecode &second);
+
+  std::vector<Bytecode> code_;
+  std::vector<Symbol> symbols_;
+  std::vector<std::string> texts_;
+};
+
+// accumulates bytecode while an instruction tree compiles itself
+class ProgramBuilder {
+public:
+  void emit(const Bytecode &bytecode);
+  size_t size() const { return program_.code_.size(); }
+  Bytecode &at(size_t index) { return program_.code_[index]; }
+  // symbols must be resolved in the order the program first touches them so
+  // addresses match the old assign-on-first-access layout
+  uint16_t resolve_symbol(const std::string &name);
+  uint16_t intern_text(const std::string &text);
+
+  // nesting of the FOR currently being compiled
+  int get_loop_depth() const { return loop_depth_; }
+  void enter_loop() { loop_depth_++; }
+  void exit_loop() { loop_depth_--; }
+
+  Program build();
+
+  // for programs decoded piecewise, drops the bytecode but keeps symbols and
+  // texts so later pieces resolve to the same addresses
+  const Program &get_program() const { return program_; }
+  void clear_code() { program_.code_.clear(); }
+
+private:
+  Program program_;
+  std::unordered_map<std::string, uint16_t> symbol_ids_;
+  std::unordered_map<std::string, uint16_t> text_ids_;
+  uint32_t next_symbol_address_ = 0x40; // start at 64 bytes
+  int loop_depth_ = 0;
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include "instructions/Program.hpp"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// shares one read-only Program between every process built from the same
+// generator and parameters or the same source text, an image is dropped once
+// the last process using it is destroyed
+class ProgramCache {
+public:
+  std::shared_ptr<const Program>
+  get_or_build(const std::string &key, const std::function<Program()> &build);
+
+private:
+  static constexpr size_t MIN_SWEEP_SIZE = 64;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::weak_ptr<const Program>> programs_;
+  // entry count that triggers the next sweep of expired images
+  size_t sweep_at_ = MIN_SWEEP_SIZE;
+
+  void drop_expired();
+};
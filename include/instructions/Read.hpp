@@ -5,7 +5,7 @@
 class Read : public IInstruction {
 public:
   Read(const std::string &var_name, uint32_t memory_address);
-  void execute(InstructionContext context) override;
+  void compile(ProgramBuilder &builder) const override;
   std::unique_ptr<IInstruction> clone() override;
 
 private:
@@ -4,7 +4,7 @@
 class Sleep : public IInstruction {
 public:
   Sleep(uint8_t ticks);
-  void execute(InstructionContext context) override;
+  void compile(ProgramBuilder &builder) const override;
   std::unique_ptr<IInstruction> clone() override;
 
 private:
@@ -6,7 +6,7 @@
 class Write : public IInstruction {
 public:
   Write(uint32_t memory_address, uint16_t value);
-  void execute(InstructionContext context) override;
+  void compile(ProgramBuilder &builder) const override;
   std::unique_ptr<IInstruction> clone() override;
 
 private:
@@ -5,6 +5,9 @@
 
 class FCFSScheduler : public IScheduler {
 public:
+  using IScheduler::add_process;
+  using IScheduler::get_next_process;
+
   virtual ~FCFSScheduler() = default;
   void add_process(Process *process) override;
   void add_process(Process *process, bool is_priority) override;
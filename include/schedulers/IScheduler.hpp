@@ -7,6 +7,13 @@ public:
   virtual void add_process(Process *process) = 0;
   virtual void add_process(Process *process, bool is_priority) = 0;
   virtual Process *get_next_process() = 0;
+
+  // per-core variants, schedulers with a single queue ignore the core id
+  virtual void add_process(Process *process, bool is_priority, int) {
+    add_process(process, is_priority);
+  }
+  virtual Process *get_next_process(int) { return get_next_process(); }
+
   virtual bool has_processes() const = 0;
   virtual bool is_running() const = 0;
   virtual void start() = 0;
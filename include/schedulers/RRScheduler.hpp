@@ -5,6 +5,9 @@
 
 class RRScheduler : public IScheduler {
 public:
+  using IScheduler::add_process;
+  using IScheduler::get_next_process;
+
   RRScheduler(int quantum_cycles);
   virtual ~RRScheduler() = default;
   void add_process(Process *process) override;
@@ -6,5 +6,6 @@
 class SchedulerFactory {
 public:
   static std::unique_ptr<IScheduler> create_scheduler(const std::string &type,
-                                                      int quantum = 0);
+                                                      int quantum = 0,
+                                                      int num_cores = 1);
 };
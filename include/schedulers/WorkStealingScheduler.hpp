@@ -0,0 +1,45 @@
+#pragma once
+#include "IScheduler.hpp"
+#include "Process.hpp"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// one run queue per core, idle cores steal from the busiest neighbour
+class WorkStealingScheduler : public IScheduler {
+public:
+  WorkStealingScheduler(int num_cores, int quantum_cycles, bool is_preemptive);
+  virtual ~WorkStealingScheduler() = default;
+  void add_process(Process *process) override;
+  void add_process(Process *process, bool is_priority) override;
+  void add_process(Process *process, bool is_priority, int core_id) override;
+  Process *get_next_process() override;
+  Process *get_next_process(int core_id) override;
+  bool has_processes() const override;
+  bool is_running() const override;
+  void start() override;
+  void stop() override;
+
+private:
+  // preempted processes keep priority over new ones, same as QueuedProcess
+  struct alignas(64) RunQueue {
+    std::mutex mutex;
+    std::deque<Process *> preempted;
+    std::deque<Process *> ready;
+    std::atomic<size_t> size = 0;
+  };
+
+  std::vector<std::unique_ptr<RunQueue>> run_queues_;
+  std::atomic<size_t> total_size_ = 0;
+  std::atomic<size_t> next_queue_ = 0;
+  std::atomic<bool> is_running_ = false;
+  int quantum_cycles_;
+  bool is_preemptive_;
+
+  void push(RunQueue &queue, Process *process, bool is_priority);
+  Process *pop(RunQueue &queue, bool is_steal);
+  RunQueue *busiest_queue(int core_id);
+  Process *dispatch(Process *process);
+};
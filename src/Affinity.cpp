@@ -0,0 +1,145 @@
+#include "Affinity.hpp"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+int read_topology_id(int cpu, const std::string &name) {
+  std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                     "/topology/" + name);
+  int id = 0;
+
+  if (!(file >> id))
+    return 0;
+
+  return id;
+}
+
+} // namespace
+
+Affinity::Placement Affinity::plan(const std::string &mode,
+                                   size_t num_cores) {
+  Placement placement;
+  placement.core_cpus.assign(num_cores, -1);
+
+  if (mode.empty() || mode == "none")
+    return placement;
+
+  if (mode != "auto") {
+    // explicit list, simulated core i runs on list[i % size]
+    std::vector<int> cpus;
+    std::stringstream ss(mode);
+    std::string token;
+
+    while (std::getline(ss, token, ','))
+      cpus.push_back(std::stoi(token));
+
+    for (size_t i = 0; i < num_cores && !cpus.empty(); ++i)
+      placement.core_cpus[i] = cpus[i % cpus.size()];
+
+    return placement;
+  }
+
+  std::vector<int> order = spread_order(allowed_cpus());
+
+  if (order.empty())
+    return placement;
+
+  // keep the cycle thread on its own cpu when there is room for it
+  if (order.size() > 1) {
+    placement.cycle_cpu = order.front();
+    order.erase(order.begin());
+  }
+
+  for (size_t i = 0; i < num_cores; ++i)
+    placement.core_cpus[i] = order[i % order.size()];
+
+  return placement;
+}
+
+bool Affinity::pin_thread(std::thread::native_handle_type thread, int cpu) {
+#ifdef __linux__
+  if (cpu < 0 || cpu >= CPU_SETSIZE)
+    return false;
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+
+  return pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set) == 0;
+#else
+  return false;
+#endif
+}
+
+// cpus this process may run on, respects cgroups and taskset
+std::vector<int> Affinity::allowed_cpus() {
+  std::vector<int> cpus;
+
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpu_set))
+        cpus.push_back(cpu);
+    }
+  }
+#endif
+
+  return cpus;
+}
+
+// orders cpus so consecutive entries land on different physical cores,
+// alternating sockets, and smt siblings only come after every physical core
+// has been used once
+std::vector<int> Affinity::spread_order(const std::vector<int> &cpus) {
+  // package -> physical core -> logical cpus
+  std::map<int, std::map<int, std::vector<int>>> topology;
+
+  for (int cpu : cpus) {
+    int package = read_topology_id(cpu, "physical_package_id");
+    int core = read_topology_id(cpu, "core_id");
+    topology[package][core].push_back(cpu);
+  }
+
+  // one list of physical cores per package, siblings kept together
+  std::vector<std::vector<std::vector<int>>> packages;
+
+  for (auto &[package, cores] : topology) {
+    packages.emplace_back();
+
+    for (auto &[core, siblings] : cores)
+      packages.back().push_back(siblings);
+  }
+
+  std::vector<int> order;
+  size_t max_siblings = 0;
+  size_t max_cores = 0;
+
+  for (const auto &package : packages) {
+    max_cores = std::max(max_cores, package.size());
+
+    for (const auto &siblings : package)
+      max_siblings = std::max(max_siblings, siblings.size());
+  }
+
+  for (size_t sibling = 0; sibling < max_siblings; ++sibling) {
+    for (size_t core = 0; core < max_cores; ++core) {
+      for (const auto &package : packages) {
+        if (core < package.size() && sibling < package[core].size())
+          order.push_back(package[core][sibling]);
+      }
+    }
+  }
+
+  return order;
+}
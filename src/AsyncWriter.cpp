@@ -0,0 +1,179 @@
+#include "AsyncWriter.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <unistd.h>
+
+AsyncWriter::AsyncWriter() : thread_([this] { run(); }) {}
+
+AsyncWriter::~AsyncWriter() {
+  // bump the count so the writer wakes up, sees the flag and exits once the
+  // stack is empty
+  stopping_.store(true, std::memory_order_release);
+  queued_.fetch_add(1, std::memory_order_release);
+  queued_.notify_one();
+  thread_.join();
+
+  for (int fd : files_)
+    ::close(fd);
+}
+
+int AsyncWriter::open(const std::string &filename, bool truncate) {
+  int fd = ::open(filename.c_str(),
+                  O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+
+  if (fd < 0)
+    throw std::runtime_error("Failed to open " + filename + ".");
+
+  std::lock_guard<std::mutex> lock(files_mutex_);
+  files_.push_back(fd);
+
+  return fd;
+}
+
+void AsyncWriter::write_at(int fd, uint64_t offset, std::string data) {
+  push(new Request{.next = nullptr,
+                   .fd = fd,
+                   .offset = offset,
+                   .truncate = false,
+                   .data = std::move(data)});
+}
+
+void AsyncWriter::replace(int fd, std::string data) {
+  push(new Request{.next = nullptr,
+                   .fd = fd,
+                   .offset = 0,
+                   .truncate = true,
+                   .data = std::move(data)});
+}
+
+void AsyncWriter::drain() {
+  uint64_t target = queued_.load(std::memory_order_acquire);
+  uint64_t written = written_.load(std::memory_order_acquire);
+
+  while (written < target) {
+    written_.wait(written, std::memory_order_acquire);
+    written = written_.load(std::memory_order_acquire);
+  }
+}
+
+void AsyncWriter::flush() {
+  drain();
+
+  std::lock_guard<std::mutex> lock(files_mutex_);
+
+  for (int fd : files_)
+    ::fsync(fd);
+}
+
+void AsyncWriter::push(Request *request) {
+  request->next = pending_.load(std::memory_order_relaxed);
+
+  while (!pending_.compare_exchange_weak(request->next, request,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed))
+    ;
+
+  // counted after the push, so a drain that sees the count also finds the
+  // request taken or still on the stack
+  queued_.fetch_add(1, std::memory_order_release);
+  queued_.notify_one();
+}
+
+void AsyncWriter::run() {
+  std::vector<Request *> requests;
+
+  while (true) {
+    uint64_t queued = queued_.load(std::memory_order_acquire);
+    Request *stack = pending_.exchange(nullptr, std::memory_order_acquire);
+
+    if (!stack) {
+      if (stopping_.load(std::memory_order_acquire))
+        break;
+
+      queued_.wait(queued, std::memory_order_acquire);
+      continue;
+    }
+
+    for (Request *request = stack; request; request = request->next)
+      requests.push_back(request);
+
+    // the stack is newest first
+    std::reverse(requests.begin(), requests.end());
+
+    write_batch(requests);
+
+    for (Request *request : requests)
+      delete request;
+
+    written_.fetch_add(requests.size(), std::memory_order_release);
+    written_.notify_all();
+    requests.clear();
+  }
+}
+
+// adjacent buffers for the same file go out in a single pwritev
+void AsyncWriter::write_batch(const std::vector<Request *> &requests) {
+  std::vector<iovec> iovecs;
+  size_t i = 0;
+
+  while (i < requests.size()) {
+    Request *first = requests[i];
+
+    if (first->truncate && ::ftruncate(first->fd, 0) != 0)
+      std::cerr << "Failed to truncate file " << first->fd << std::endl;
+
+    uint64_t end = first->offset;
+    iovecs.clear();
+
+    while (i < requests.size() && requests[i]->fd == first->fd &&
+           requests[i]->offset == end && iovecs.size() < IOV_MAX &&
+           (requests[i] == first || !requests[i]->truncate)) {
+      // an empty buffer writes nothing, a truncate still applies
+      if (!requests[i]->data.empty())
+        iovecs.push_back(iovec{.iov_base = requests[i]->data.data(),
+                               .iov_len = requests[i]->data.size()});
+      end += requests[i]->data.size();
+      i++;
+    }
+
+    uint64_t offset = first->offset;
+    size_t next = 0;
+
+    // pwritev may stop short, resume from where it left off
+    while (next < iovecs.size()) {
+      ssize_t count = ::pwritev(first->fd, &iovecs[next],
+                                iovecs.size() - next, offset);
+
+      if (count < 0 && errno == EINTR)
+        continue;
+
+      // no progress or a real error, the rest of the run is lost
+      if (count <= 0) {
+        std::cerr << "Failed to write to file " << first->fd << ": "
+                  << (count < 0 ? std::strerror(errno) : "no bytes written")
+                  << std::endl;
+        break;
+      }
+
+      offset += count;
+
+      while (next < iovecs.size() &&
+             static_cast<size_t>(count) >= iovecs[next].iov_len) {
+        count -= iovecs[next].iov_len;
+        next++;
+      }
+
+      if (next < iovecs.size()) {
+        iovecs[next].iov_base =
+            static_cast<char *>(iovecs[next].iov_base) + count;
+        iovecs[next].iov_len -= count;
+      }
+    }
+  }
+}
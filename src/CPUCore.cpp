@@ -1,15 +1,73 @@
 #include "CPUCore.hpp"
 #include "Process.hpp"
+#include <algorithm>
 #include <chrono>
 
-CPUCore::CPUCore(int id, const std::string scheduler, const int delay_per_exec)
-    : id_(id), scheduler_(scheduler), delay_per_exec_(delay_per_exec) {}
+CoreStats &CoreStats::operator+=(const CoreStats &other) {
+  active_ticks += other.active_ticks;
+  idle_ticks += other.idle_ticks;
+  instructions += other.instructions;
+  preemptions += other.preemptions;
+  sleeps += other.sleeps;
+
+  return *this;
+}
+
+CPUCore::CPUCore(int id, const std::string scheduler, const int delay_per_exec,
+                 const bool is_virtual_delay, const bool is_fusion_enabled)
+    : id_(id), scheduler_(scheduler),
+      is_preemptive_(scheduler == "rr" || scheduler == "rr-ws"),
+      delay_per_exec_(delay_per_exec), is_virtual_delay_(is_virtual_delay),
+      is_fusion_enabled_(is_fusion_enabled) {}
 
 Process *CPUCore::tick(MemoryManager *memory_manager) {
-  busy_wait(delay_per_exec_);
+  uint32_t ticks = 0;
+  return step(memory_manager, 1, ticks);
+}
+
+// runs the current process for up to max_ticks instructions without going
+// back to the scheduler, stops early when the process leaves the core
+// ticks left over after that are charged as idle
+Process *CPUCore::run(MemoryManager *memory_manager, uint32_t max_ticks) {
+  Process *returned_process = nullptr;
+  uint32_t ticks_executed = 0;
+
+  while (current_process_ && ticks_executed < max_ticks) {
+    uint32_t ticks = 0;
+    returned_process = step(memory_manager, max_ticks - ticks_executed, ticks);
+    ticks_executed += ticks;
+
+    if (returned_process)
+      break;
+  }
+
+  increment(counters_->active_ticks, ticks_executed);
+
+  if (ticks_executed < max_ticks)
+    increment(counters_->idle_ticks, max_ticks - ticks_executed);
+
+  return returned_process;
+}
+
+// one dispatch of the current process, a superinstruction runs its
+// instructions together but still costs one tick and one delay each
+// it is only taken when both max_ticks and the quantum cover all of them
+Process *CPUCore::step(MemoryManager *memory_manager, uint32_t max_ticks,
+                       uint32_t &ticks) {
+  int max_width = is_fusion_enabled_ ? int(max_ticks) : 1;
+
+  if (is_preemptive_)
+    max_width = std::min(
+        max_width, std::max(current_process_->get_quantum_remaining(), 1));
 
-  current_process_->execute_current_instruction(id_, memory_manager);
-  current_process_->increment_instruction_pointer();
+  int width = current_process_->get_instruction_width(max_width);
+  ticks = width;
+
+  busy_wait(delay_per_exec_ * width);
+
+  current_process_->execute_current_instruction(id_, memory_manager, width);
+  current_process_->increment_instruction_pointer(width);
+  increment(counters_->instructions, width);
 
   if (current_process_->get_state() == Process::ProcessState::TERMINATED) {
     Process *finished_process = current_process_;
@@ -19,17 +77,20 @@ Process *CPUCore::tick(MemoryManager *memory_manager) {
   }
 
   if (current_process_->get_state() == Process::ProcessState::SLEEPING) {
+    increment(counters_->sleeps);
+
     Process *waiting_process = current_process_;
     current_process_ = nullptr;
 
     return waiting_process;
   }
 
-  if (scheduler_ == "rr") {
-    current_process_->decrement_quantum_remaining();
+  if (is_preemptive_) {
+    current_process_->decrement_quantum_remaining(width);
 
     if (current_process_->is_quantum_expired()) {
       current_process_->set_state(Process::ProcessState::READY);
+      increment(counters_->preemptions);
 
       Process *preempted_process = current_process_;
       current_process_ = nullptr;
@@ -41,6 +102,8 @@ Process *CPUCore::tick(MemoryManager *memory_manager) {
   return nullptr;
 }
 
+void CPUCore::idle(uint64_t ticks) { increment(counters_->idle_ticks, ticks); }
+
 const bool CPUCore::is_idle() const { return current_process_ == nullptr; }
 
 const Process *CPUCore::get_current_process() const { return current_process_; }
@@ -54,10 +117,32 @@ void CPUCore::set_current_process(Process *process) {
     current_process_->set_state(Process::ProcessState::RUNNING);
 }
 
+const CoreStats CPUCore::get_stats() const {
+  return CoreStats{
+      .active_ticks = counters_->active_ticks.load(std::memory_order_relaxed),
+      .idle_ticks = counters_->idle_ticks.load(std::memory_order_relaxed),
+      .instructions = counters_->instructions.load(std::memory_order_relaxed),
+      .preemptions = counters_->preemptions.load(std::memory_order_relaxed),
+      .sleeps = counters_->sleeps.load(std::memory_order_relaxed)};
+}
+
+// delay charged since the last call, in microseconds
+uint64_t CPUCore::take_virtual_delay() {
+  uint64_t delay = virtual_delay_;
+  virtual_delay_ = 0;
+
+  return delay;
+}
+
 void CPUCore::busy_wait(int cycles) {
   if (cycles <= 0)
     return;
 
+  if (is_virtual_delay_) {
+    virtual_delay_ += cycles;
+    return;
+  }
+
   auto start_time = std::chrono::high_resolution_clock::now();
   auto end_time =
       start_time + std::chrono::microseconds(cycles); // 1 cycle = 1 microsecond
@@ -65,3 +150,10 @@ void CPUCore::busy_wait(int cycles) {
   while (std::chrono::high_resolution_clock::now() < end_time)
     ;
 }
+
+// single writer, so a plain load + store is enough and avoids a locked
+// read-modify-write on the hot path
+void CPUCore::increment(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
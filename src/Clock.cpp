@@ -0,0 +1,32 @@
+#include "Clock.hpp"
+#include <chrono>
+
+std::atomic<std::time_t> Clock::now_ =
+    std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+void Clock::refresh() {
+  now_.store(
+      std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()),
+      std::memory_order_relaxed);
+}
+
+std::string Clock::format(std::time_t time) {
+  // logs are mostly formatted in runs sharing the same second, so each thread
+  // keeps its last result and only calls localtime_r when the second changes
+  thread_local std::time_t formatted_time = -1;
+  thread_local std::string formatted;
+
+  if (time == formatted_time)
+    return formatted;
+
+  std::tm local_time{};
+  localtime_r(&time, &local_time);
+
+  char buffer[30];
+  std::strftime(buffer, sizeof(buffer), "%m/%d/%Y %I:%M:%S%p", &local_time);
+
+  formatted_time = time;
+  formatted = buffer;
+
+  return formatted;
+}
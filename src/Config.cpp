@@ -1,8 +1,10 @@
 #include "Config.hpp"
 #include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <sstream>
 
 Config::Config() {
   num_cpu_ = 4;
@@ -12,6 +14,14 @@ Config::Config() {
   min_ins_ = 1000;
   max_ins_ = 2000;
   delay_per_exec_ = 0;
+  execution_mode_ = "lockstep";
+  delay_mode_ = "spin";
+  random_seed_ = 0; // 0 = time based
+  cpu_affinity_ = "none";
+  program_generator_ = "hardcoded";
+  fuse_instructions_ = "off";
+  log_buffer_size_ = 256;
+  log_spill_ = "off";
 
   max_overall_mem_ = 16384; // 2^14
   mem_per_frame_ = 256;     // 2^8
@@ -48,10 +58,12 @@ bool Config::load(const std::string &filename) {
       scheduler.erase(std::remove(scheduler.begin(), scheduler.end(), '\"'),
                       scheduler.end()); // remove quotes if any
       //
-      if (scheduler != "rr" && scheduler != "fcfs") {
+      if (scheduler != "rr" && scheduler != "fcfs" && scheduler != "rr-ws" &&
+          scheduler != "fcfs-ws") {
         std::cerr << "Invalid scheduler type: " << scheduler
                   << ". Defaulting to 'rr'." << std::endl;
         scheduler_ = "rr";
+        continue;
       }
 
       scheduler_ = scheduler;
@@ -133,6 +145,129 @@ bool Config::load(const std::string &filename) {
       }
 
       delay_per_exec_ = static_cast<uint32_t>(val_ul);
+    } else if (key == "execution-mode") {
+      std::string execution_mode = val;
+
+      execution_mode.erase(
+          std::remove(execution_mode.begin(), execution_mode.end(), '\"'),
+          execution_mode.end()); // remove quotes if any
+
+      if (execution_mode != "lockstep" && execution_mode != "quantum") {
+        std::cerr << "Invalid execution mode: " << execution_mode
+                  << ". Defaulting to 'lockstep'." << std::endl;
+        execution_mode_ = "lockstep";
+        continue;
+      }
+
+      execution_mode_ = execution_mode;
+    } else if (key == "delay-mode") {
+      std::string delay_mode = val;
+
+      delay_mode.erase(std::remove(delay_mode.begin(), delay_mode.end(), '\"'),
+                       delay_mode.end()); // remove quotes if any
+
+      if (delay_mode != "spin" && delay_mode != "virtual") {
+        std::cerr << "Invalid delay mode: " << delay_mode
+                  << ". Defaulting to 'spin'." << std::endl;
+        delay_mode_ = "spin";
+        continue;
+      }
+
+      delay_mode_ = delay_mode;
+    } else if (key == "random-seed") {
+      random_seed_ = std::stoull(val);
+    } else if (key == "cpu-affinity") {
+      std::string cpu_affinity = val;
+
+      cpu_affinity.erase(
+          std::remove(cpu_affinity.begin(), cpu_affinity.end(), '\"'),
+          cpu_affinity.end()); // remove quotes if any
+
+      // every comma separated entry must be a cpu number that fits an int
+      bool is_cpu_list = !cpu_affinity.empty();
+      std::stringstream cpus(cpu_affinity);
+      std::string cpu;
+
+      while (is_cpu_list && std::getline(cpus, cpu, ','))
+        is_cpu_list =
+            !cpu.empty() && cpu.size() <= 9 &&
+            std::all_of(cpu.begin(), cpu.end(), [](char c) {
+              return std::isdigit(static_cast<unsigned char>(c));
+            });
+
+      // getline drops a trailing empty entry
+      if (is_cpu_list && cpu_affinity.back() == ',')
+        is_cpu_list = false;
+
+      if (cpu_affinity != "none" && cpu_affinity != "auto" && !is_cpu_list) {
+        std::cerr << "Invalid cpu affinity: " << cpu_affinity
+                  << ". Defaulting to 'none'." << std::endl;
+        cpu_affinity_ = "none";
+        continue;
+      }
+
+      cpu_affinity_ = cpu_affinity;
+    } else if (key == "program-generator") {
+      std::string program_generator = val;
+
+      program_generator.erase(
+          std::remove(program_generator.begin(), program_generator.end(),
+                      '\"'),
+          program_generator.end()); // remove quotes if any
+
+      if (program_generator != "hardcoded" && program_generator != "random" &&
+          program_generator != "mo1") {
+        std::cerr << "Invalid program generator: " << program_generator
+                  << ". Defaulting to 'hardcoded'." << std::endl;
+        program_generator_ = "hardcoded";
+        continue;
+      }
+
+      program_generator_ = program_generator;
+    } else if (key == "fuse-instructions") {
+      std::string fuse_instructions = val;
+
+      fuse_instructions.erase(
+          std::remove(fuse_instructions.begin(), fuse_instructions.end(),
+                      '\"'),
+          fuse_instructions.end()); // remove quotes if any
+
+      if (fuse_instructions != "on" && fuse_instructions != "off") {
+        std::cerr << "Invalid fuse instructions: " << fuse_instructions
+                  << ". Defaulting to 'off'." << std::endl;
+        fuse_instructions_ = "off";
+        continue;
+      }
+
+      fuse_instructions_ = fuse_instructions;
+    } else if (key == "log-buffer-size") {
+      uint64_t val_ul = std::stoul(val);
+
+      if (val_ul < 1 || val_ul > std::numeric_limits<uint32_t>::max()) {
+        std::cerr << "Invalid log buffer size: " << val
+                  << ". Must be between 1 and "
+                  << std::numeric_limits<uint32_t>::max()
+                  << ". Clamping to valid range." << std::endl;
+        log_buffer_size_ = static_cast<uint32_t>(std::clamp<uint64_t>(
+            val_ul, 1, std::numeric_limits<uint32_t>::max()));
+        continue;
+      }
+
+      log_buffer_size_ = static_cast<uint32_t>(val_ul);
+    } else if (key == "log-spill") {
+      std::string log_spill = val;
+
+      log_spill.erase(std::remove(log_spill.begin(), log_spill.end(), '\"'),
+                      log_spill.end()); // remove quotes if any
+
+      if (log_spill != "on" && log_spill != "off") {
+        std::cerr << "Invalid log spill: " << log_spill
+                  << ". Defaulting to 'off'." << std::endl;
+        log_spill_ = "off";
+        continue;
+      }
+
+      log_spill_ = log_spill;
     } else if (key == "max-overall-mem") {
       max_overall_mem_ = static_cast<uint32_t>(std::stoul(val));
     } else if (key == "mem-per-frame") {
@@ -159,6 +294,18 @@ uint32_t Config::get_batch_process_freq() const { return batch_process_freq_; }
 uint32_t Config::get_min_ins() const { return min_ins_; }
 uint32_t Config::get_max_ins() const { return max_ins_; }
 uint32_t Config::get_delay_per_exec() const { return delay_per_exec_; }
+std::string Config::get_execution_mode() const { return execution_mode_; }
+std::string Config::get_delay_mode() const { return delay_mode_; }
+uint64_t Config::get_random_seed() const { return random_seed_; }
+std::string Config::get_cpu_affinity() const { return cpu_affinity_; }
+std::string Config::get_program_generator() const {
+  return program_generator_;
+}
+std::string Config::get_fuse_instructions() const {
+  return fuse_instructions_;
+}
+uint32_t Config::get_log_buffer_size() const { return log_buffer_size_; }
+std::string Config::get_log_spill() const { return log_spill_; }
 
 uint32_t Config::get_max_overall_mem() const { return max_overall_mem_; }
 uint32_t Config::get_mem_per_frame() const { return mem_per_frame_; }
@@ -1,10 +1,14 @@
 #include "Emulator.hpp"
+#include "Clock.hpp"
 #include "Process.hpp"
+#include "Random.hpp"
+#include "Utils.hpp"
 #include "instructions/InstructionFactory.hpp"
 #include "schedulers/SchedulerFactory.hpp"
 #include <algorithm>
-#include <fstream>
+#include <chrono>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 
 Emulator::Emulator() {
@@ -32,6 +36,10 @@ Emulator::Emulator() {
       "report-util",
       [this](const std::vector<std::string> &args) { this->report_util(); });
 
+  parser_.registerCommand(
+      "flush",
+      [this](const std::vector<std::string> &args) { this->flush(); });
+
   parser_.registerCommand(
       "process-smi",
       [this](const std::vector<std::string> &args) { this->process_smi(); });
@@ -40,7 +48,20 @@ Emulator::Emulator() {
       [this](const std::vector<std::string> &args) { this->vmstat(); });
 }
 
+Emulator::~Emulator() {
+  // stop the cycle thread first so it can release the core workers before
+  // the cores and memory manager they use are destroyed
+  if (cycle_thread_.joinable()) {
+    cycle_thread_.request_stop();
+    cycle_thread_.join();
+  }
+}
+
 bool Emulator::process_input(const std::string &input) {
+  // processes created by this command are stamped with the current time even
+  // while the cycle thread is parked
+  Clock::refresh();
+
   try {
     parser_.executeCommand(input);
   } catch (const std::exception &e) {
@@ -53,9 +74,156 @@ bool Emulator::process_input(const std::string &input) {
   return true;
 }
 
+void Emulator::run_benchmark(const BenchmarkOptions &options) {
+  max_cycles_ = options.cycles;
+
+  setup(options.config_file);
+  scheduler_->start();
+
+  if (options.seed != 0)
+    Random::set_seed(options.seed);
+
+  auto start_time = std::chrono::steady_clock::now();
+  start_cycle_thread();
+
+  // wait for the cycle limit or the time limit, whichever comes first
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto done = [this] { return cycle_thread_done_; };
+
+    if (options.seconds > 0.0)
+      cv_.wait_until(lock,
+                     start_time + std::chrono::duration_cast<
+                                      std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double>(
+                                          options.seconds)),
+                     done);
+    else
+      cv_.wait(lock, done);
+  }
+
+  cycle_thread_.request_stop();
+  cycle_thread_.join();
+
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+
+  CoreStats core_stats = get_core_stats();
+  uint64_t instructions = core_stats.instructions;
+  uint64_t cycles = cpu_cycles_;
+
+  // machine readable results, one json object on stdout
+  std::cout << "{\"config\": \"" << Utils::json_escape(options.config_file)
+            << "\""
+            << ", \"seed\": " << Random::get_seed()
+            << ", \"scheduler\": \"" << config_.get_scheduler() << "\""
+            << ", \"execution_mode\": \"" << config_.get_execution_mode()
+            << "\"" << ", \"fuse_instructions\": \""
+            << config_.get_fuse_instructions() << "\""
+            << ", \"num_cpu\": " << cores_.size()
+            << ", \"seconds\": " << elapsed << ", \"cycles\": " << cycles
+            << ", \"cycles_per_sec\": " << cycles / elapsed
+            << ", \"instructions\": " << instructions
+            << ", \"instructions_per_sec\": " << instructions / elapsed
+            << ", \"processes_created\": " << process_count_
+            << ", \"processes_finished\": " << terminated_processes_.size()
+            << ", \"paged_in\": " << memory_manager_->get_paged_in_count()
+            << ", \"paged_out\": " << memory_manager_->get_paged_out_count()
+            << ", \"preemptions\": " << core_stats.preemptions
+            << ", \"sleeps\": " << core_stats.sleeps
+            << ", \"idle_cpu_ticks\": " << core_stats.idle_ticks
+            << ", \"active_cpu_ticks\": " << core_stats.active_ticks
+            << ", \"total_cpu_ticks\": "
+            << core_stats.idle_ticks + core_stats.active_ticks
+            << ", \"peak_rss_kb\": " << Utils::peak_rss_kb() << "}"
+            << std::endl;
+}
+
+// executes instructions back to back on one process without the cycle loop,
+// isolates the per-instruction cost of the execution path
+void Emulator::run_instruction_benchmark(const BenchmarkOptions &options) {
+  if (!config_.load(options.config_file))
+    throw std::runtime_error("Configuration not loaded.");
+
+  Random::set_seed(options.seed != 0 ? options.seed : 1);
+
+  MemoryManager memory_manager(config_.get_max_overall_mem(),
+                               config_.get_mem_per_frame(),
+                               "csopesy-backing-store.txt");
+
+  RandomStream rng = Random::stream(Random::Domain::PROCESS_GENERATION, 0);
+  const int program_length = 1000;
+
+  uint64_t instructions = 0;
+  int process_count = 0;
+  bool is_fusion_enabled = config_.get_fuse_instructions() == "on";
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  while (instructions < options.micro_instructions) {
+    // mo1 demo program, PRINT and ADD on variables, no paging beyond the
+    // first fault so the instruction path dominates
+    Clock::refresh();
+
+    auto process = std::make_unique<Process>(
+        "bench" + std::to_string(process_count++), program_length,
+        config_.get_quantum_cycles());
+
+    process->set_instructions(InstructionFactory::create_mo1_demo_instructions(
+        process->get_name(), program_length, rng));
+
+    memory_manager.register_process(process.get(),
+                                    config_.get_max_mem_per_proc(),
+                                    config_.get_mem_per_frame());
+
+    while (process->get_state() != Process::ProcessState::TERMINATED &&
+           instructions < options.micro_instructions) {
+      int max_width =
+          is_fusion_enabled
+              ? int(std::min<uint64_t>(MAX_FUSED_WIDTH,
+                                       options.micro_instructions -
+                                           instructions))
+              : 1;
+      int width = process->get_instruction_width(max_width);
+
+      process->execute_current_instruction(0, &memory_manager, width);
+      process->increment_instruction_pointer(width);
+      instructions += width;
+    }
+
+    memory_manager.remove_process(process->get_id());
+  }
+
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+
+  std::cout << "{\"benchmark\": \"instruction\""
+            << ", \"fuse_instructions\": \""
+            << config_.get_fuse_instructions() << "\""
+            << ", \"instructions\": " << instructions
+            << ", \"seconds\": " << elapsed
+            << ", \"ns_per_instruction\": " << elapsed * 1e9 / instructions
+            << ", \"peak_rss_kb\": " << Utils::peak_rss_kb() << "}"
+            << std::endl;
+}
+
 void Emulator::cycle(std::stop_token st) {
-  while (!st.stop_requested()) {
-    int busy_cores = 0;
+  while (!st.stop_requested() &&
+         (max_cycles_ == 0 || cpu_cycles_ < max_cycles_)) {
+    // park until there is something to run, then pick up new processes
+    wait_for_work(st);
+
+    if (st.stop_requested())
+      break;
+
+    // one clock read per cycle stamps every log the cores write in it
+    Clock::refresh();
+
+    // nothing can run until a sleeper wakes up, jump straight to it
+    fast_forward_idle_cycles();
+
     uint32_t available_frames = memory_manager_->get_free_frames_size();
     uint32_t max_concurrent_processes = std::max(1u, available_frames);
     uint32_t current_running_processes = 0;
@@ -66,27 +234,27 @@ void Emulator::cycle(std::stop_token st) {
     }
 
     // assign processes to idle cores
-    busy_cores =
-        assign_processes(current_running_processes, max_concurrent_processes) +
-        current_running_processes;
-
-    // update cpu stats
-    total_cpu_ticks_ += cores_.size(); // each core = one tick
-    active_cpu_ticks_ += busy_cores;
-    idle_cpu_ticks_ += (cores_.size() - busy_cores);
+    assign_processes(current_running_processes, max_concurrent_processes);
 
     // tick all cores and collect returned processes
-    std::vector<Process *> returned_processes = tick_cores();
+    // each core charges its own active and idle ticks
+    const std::vector<Process *> &returned_processes = tick_cores();
+
+    // wait out the delay the cores charged in virtual delay mode
+    pace_cycle(st);
 
-    // generate new processes if scheduler is .get()running
-    if (scheduler_->is_running())
-      generate_processes();
+    // generate new processes if scheduler is running
+    if (scheduler_->is_running()) {
+      for (uint32_t i = 0; i < ticks_per_cycle_; ++i)
+        generate_processes();
+    }
 
     // handle returned processes
     handle_returned_processes(returned_processes);
 
     // handle sleeping processes
-    handle_sleeping_processes();
+    for (uint32_t i = 0; i < ticks_per_cycle_; ++i)
+      handle_sleeping_processes();
 
     available_frames = memory_manager_->get_free_frames_size();
     max_concurrent_processes = std::max(1u, available_frames);
@@ -102,14 +270,18 @@ void Emulator::cycle(std::stop_token st) {
     // sleep to prevent process from terminating too fast for debugging
     // std::this_thread::sleep_for(std::chrono::milliseconds(300)); // commented
     // out in actual demo for accuracy purposes
-    cpu_cycles_++;
+    cpu_cycles_ += ticks_per_cycle_;
 
-    // cycle finished -> notify waiting thread
-    {
-      std::lock_guard<std::mutex> lock(mtx_);
-      cycle_finished_ = true;
-      cv_.notify_one();
-    }
+    // cycle finished -> publish stats for monitoring commands
+    publish_stats_snapshot();
+  }
+
+  stop_core_workers();
+
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    cycle_thread_done_ = true;
+    cv_.notify_all();
   }
 }
 
@@ -122,7 +294,7 @@ uint32_t Emulator::assign_processes(uint32_t current_running_processes,
                                 max_concurrent_processes;
        ++i) {
     if (cores_[i].is_idle() && scheduler_->has_processes()) {
-      Process *next_process = scheduler_->get_next_process();
+      Process *next_process = scheduler_->get_next_process(i);
 
       if (next_process) {
         bool is_registered =
@@ -143,7 +315,7 @@ uint32_t Emulator::assign_processes(uint32_t current_running_processes,
             assigned_processes++;
           } else {
             // not enough memory, schedule for later
-            scheduler_->add_process(next_process, true);
+            scheduler_->add_process(next_process, true, i);
           }
         }
       }
@@ -153,25 +325,84 @@ uint32_t Emulator::assign_processes(uint32_t current_running_processes,
   return assigned_processes;
 }
 
-std::vector<Process *> Emulator::tick_cores() {
-  std::vector<Process *> returned_processes(cores_.size());
+const std::vector<Process *> &Emulator::tick_cores() {
+  std::fill(returned_processes_.begin(), returned_processes_.end(), nullptr);
 
-  // tick all cores in parallel
-  // auto join after scope ends
-  {
-    std::vector<std::jthread> core_threads;
-    core_threads.reserve(cores_.size());
-
-    for (size_t i = 0; i < cores_.size(); ++i) {
-      if (!cores_[i].is_idle()) {
-        core_threads.emplace_back([this, i, &returned_processes]() {
-          returned_processes[i] = cores_[i].tick(memory_manager_.get());
-        });
-      }
-    }
+  bool any_busy =
+      std::any_of(cores_.begin(), cores_.end(),
+                  [](const CPUCore &core) { return !core.is_idle(); });
+
+  // nothing to tick, skip the round trip through the workers
+  if (!any_busy) {
+    for (auto &core : cores_)
+      core.idle(ticks_per_cycle_);
+
+    return returned_processes_;
+  }
+
+  // release the workers, then wait for every core to finish its tick
+  tick_barrier_->arrive_and_wait();
+  tick_barrier_->arrive_and_wait();
+
+  return returned_processes_;
+}
+
+void Emulator::core_worker(size_t core_index) {
+  CPUCore &core = cores_[core_index];
+
+  while (true) {
+    tick_barrier_->arrive_and_wait();
+
+    if (workers_stopping_)
+      return;
+
+    if (!core.is_idle())
+      returned_processes_[core_index] =
+          core.run(memory_manager_.get(), ticks_per_cycle_);
+    else
+      core.idle(ticks_per_cycle_);
+
+    tick_barrier_->arrive_and_wait();
   }
+}
+
+void Emulator::start_core_workers() {
+  // planned before any worker exists, so a bad affinity cannot leave
+  // workers parked on the barrier
+  placement_ = Affinity::plan(config_.get_cpu_affinity(), cores_.size());
+  returned_processes_.assign(cores_.size(), nullptr);
 
-  return returned_processes;
+  // cycle thread + one worker per core
+  tick_barrier_ = std::make_unique<std::barrier<>>(cores_.size() + 1);
+
+  core_workers_.reserve(cores_.size());
+
+  for (size_t i = 0; i < cores_.size(); ++i)
+    core_workers_.emplace_back([this, i]() { core_worker(i); });
+
+  // pin each worker to its host cpu when an affinity is configured
+  for (size_t i = 0; i < core_workers_.size(); ++i) {
+    int cpu = placement_.core_cpus[i];
+
+    if (cpu >= 0 &&
+        !Affinity::pin_thread(core_workers_[i].native_handle(), cpu))
+      std::cerr << "Failed to pin core " << i << " to host cpu " << cpu
+                << std::endl;
+  }
+}
+
+void Emulator::stop_core_workers() {
+  if (core_workers_.empty())
+    return;
+
+  // workers are parked on the first barrier phase, wake them up to exit
+  workers_stopping_ = true;
+  tick_barrier_->arrive_and_wait();
+
+  for (auto &worker : core_workers_)
+    worker.join();
+
+  core_workers_.clear();
 }
 
 void Emulator::generate_processes() {
@@ -179,45 +410,64 @@ void Emulator::generate_processes() {
 
   // generate batch_freq amount of processes
   for (int i = 0; i < batch_freq; ++i) {
+    // every generated process gets its own stream, so a seed reproduces the
+    // same workload no matter which thread generates it
+    RandomStream rng =
+        Random::stream(Random::Domain::PROCESS_GENERATION, process_count_);
+
     std::string process_name = "p" + std::to_string(process_count_++);
 
     int num_instructions =
-        config_.get_min_ins() +
-        (rand() % (config_.get_max_ins() - config_.get_min_ins() + 1));
-    /*
-     std::vector<std::unique_ptr<IInstruction>> instructions =
-         InstructionFactory::create_instructions(process_name,
-       num_instructions, config_.get_max_ins(), config_.get_min_ins());
-   */
-
-    /*
-    std::vector<std::unique_ptr<IInstruction>> instructions =
-        InstructionFactory::create_mo1_demo_instructions(process_name,
-                                                         num_instructions);
-    */
-
-    std::vector<std::unique_ptr<IInstruction>> instructions =
-        InstructionFactory::create_hardcoded_instructions(process_name);
+        rng.next_in_range(config_.get_min_ins(), config_.get_max_ins());
 
     std::unique_ptr<Process> process = std::make_unique<Process>(
         process_name, num_instructions, config_.get_quantum_cycles());
 
-    process->set_instructions(std::move(instructions));
+    process->set_log_buffer(config_.get_log_buffer_size(), log_segment_.get());
+    load_program(*process, num_instructions, rng);
 
     uint32_t min_mem_per_process = config_.get_min_mem_per_proc();
     uint32_t max_mem_per_process = config_.get_max_mem_per_proc();
 
     uint32_t random_memory_size =
-        min_mem_per_process +
-        (rand() % (max_mem_per_process - min_mem_per_process + 1));
+        rng.next_in_range(min_mem_per_process, max_mem_per_process);
 
     if (memory_manager_) {
       memory_manager_->register_process(process.get(), random_memory_size,
                                         config_.get_mem_per_frame());
     }
 
-    processes_[process_name] = std::move(process);
-    scheduler_->add_process(processes_[process_name].get());
+    Process *new_process = process.get();
+
+    {
+      std::lock_guard<std::mutex> lock(processes_mutex_);
+      processes_[process_name] = std::move(process);
+    }
+
+    scheduler_->add_process(new_process);
+  }
+}
+
+// gives a new process its program according to program-generator
+void Emulator::load_program(Process &process, int num_instructions,
+                            RandomStream &rng) {
+  std::string generator = config_.get_program_generator();
+
+  if (generator == "random") {
+    // decoded from a copy of the stream as the process runs
+    process.set_instruction_stream(std::make_unique<InstructionStream>(
+        process.get_name(), num_instructions, config_.get_max_ins(),
+        config_.get_min_ins(), rng));
+  } else if (generator == "mo1") {
+    process.set_instructions(InstructionFactory::create_mo1_demo_instructions(
+        process.get_name(), num_instructions, rng));
+  } else {
+    // the hardcoded program does not depend on the process name, so every
+    // process shares a single image
+    process.set_program(program_cache_.get_or_build("hardcoded", [&process] {
+      return Program::compile(InstructionFactory::create_hardcoded_instructions(
+          process.get_name()));
+    }));
   }
 }
 
@@ -239,10 +489,10 @@ void Emulator::handle_returned_processes(
       }
       break;
     case Process::ProcessState::READY: {
-      scheduler_->add_process(returned_process);
+      scheduler_->add_process(returned_process, false, i);
 
       if (cores_[i].is_idle() && scheduler_->has_processes()) {
-        Process *next_process = scheduler_->get_next_process();
+        Process *next_process = scheduler_->get_next_process(i);
 
         if (next_process) {
           bool is_registered =
@@ -258,7 +508,7 @@ void Emulator::handle_returned_processes(
             if (free_memory > process_memory_size) {
               cores_[i].set_current_process(next_process);
             } else {
-              scheduler_->add_process(next_process, true);
+              scheduler_->add_process(next_process, true, i);
             }
           }
         }
@@ -267,7 +517,8 @@ void Emulator::handle_returned_processes(
       break;
     }
     case Process::ProcessState::SLEEPING:
-      sleeping_processes_.push_back(returned_process);
+      sleeping_processes_.schedule(returned_process,
+                                   returned_process->get_sleep_ticks());
       break;
     default:
       break;
@@ -276,43 +527,231 @@ void Emulator::handle_returned_processes(
 }
 
 void Emulator::handle_sleeping_processes() {
-  auto it = std::remove_if(sleeping_processes_.begin(),
-                           sleeping_processes_.end(), [this](Process *process) {
-                             process->decrement_sleep_ticks();
-                             if (process->get_state() ==
-                                 Process::ProcessState::READY) {
-                               scheduler_->add_process(process, true);
-                               return true;
-                             }
-                             return false;
-                           });
-  sleeping_processes_.erase(it, sleeping_processes_.end());
+  // one tick of the wheel, only the processes waking up now are touched
+  for (Process *process : sleeping_processes_.advance()) {
+    process->wake();
+    scheduler_->add_process(process, true);
+  }
+}
+
+void Emulator::fast_forward_idle_cycles() {
+  // batch generation adds work every tick while the scheduler is running
+  if (scheduler_->is_running() || scheduler_->has_processes() ||
+      sleeping_processes_.empty())
+    return;
+
+  for (const auto &core : cores_) {
+    if (!core.is_idle())
+      return;
+  }
+
+  uint64_t skipped_ticks = sleeping_processes_.ticks_until_next_expiry();
+
+  if (max_cycles_ != 0)
+    skipped_ticks = std::min(skipped_ticks, max_cycles_ - cpu_cycles_);
+
+  if (skipped_ticks == 0)
+    return;
+
+  // account the skipped ticks exactly as idle cycles would have
+  for (auto &core : cores_)
+    core.idle(skipped_ticks);
+
+  sleeping_processes_.skip(skipped_ticks);
+  cpu_cycles_ += skipped_ticks;
+}
+
+void Emulator::wait_for_work(std::stop_token st) {
+  std::unique_lock<std::mutex> lock(mtx_);
+
+  if (pending_processes_.empty() && !has_work()) {
+    wake_cv_.wait(lock, st, [this] {
+      return !pending_processes_.empty() || scheduler_->is_running();
+    });
+  }
+
+  for (Process *process : pending_processes_)
+    scheduler_->add_process(process);
+
+  pending_processes_.clear();
+}
+
+bool Emulator::has_work() const {
+  if (scheduler_->is_running() || scheduler_->has_processes() ||
+      !sleeping_processes_.empty())
+    return true;
+
+  return std::any_of(cores_.begin(), cores_.end(),
+                     [](const CPUCore &core) { return !core.is_idle(); });
+}
+
+// hands a process created by the shell over to the cycle thread
+void Emulator::submit_process(Process *process) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    pending_processes_.push_back(process);
+  }
+
+  wake_cv_.notify_one();
+}
+
+void Emulator::publish_stats_snapshot() {
+  // reuse the snapshot published two cycles ago once no reader holds it
+  if (!spare_snapshot_ || spare_snapshot_.use_count() != 1)
+    spare_snapshot_ = std::make_shared<StatsSnapshot>();
+
+  // use_count is a relaxed load, pairs with the release of the last reader's
+  // reference so its reads finish before the snapshot is overwritten
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  StatsSnapshot &snapshot = *spare_snapshot_;
+  uint32_t mem_per_frame = config_.get_mem_per_frame();
+
+  snapshot.cpu_cycles = cpu_cycles_;
+  snapshot.is_scheduler_running = scheduler_->is_running();
+  snapshot.num_cores = cores_.size();
+
+  snapshot.running_processes.clear();
+
+  for (size_t i = 0; i < cores_.size(); ++i) {
+    const Process *process = cores_[i].get_current_process();
+
+    if (!process)
+      continue;
+
+    snapshot.running_processes.push_back(
+        {process, static_cast<int>(i), process->get_instruction_pointer(),
+         process->get_total_instructions(),
+         process->get_resident_pages() * mem_per_frame});
+  }
+
+  // used to limit log output to first 10 entries to avoid bloating the
+  // file/screen
+  size_t finished_count = std::min<size_t>(terminated_processes_.size(), 10);
+
+  snapshot.finished_processes.clear();
+
+  for (size_t i = 0; i < finished_count; ++i) {
+    const Process *process = terminated_processes_[i];
+
+    snapshot.finished_processes.push_back(
+        {process, -1, process->get_instruction_pointer(),
+         process->get_total_instructions(), 0});
+  }
+
+  snapshot.finished_count = terminated_processes_.size();
+
+  snapshot.total_memory_size = memory_manager_->get_total_memory_size();
+  snapshot.used_memory_size = memory_manager_->get_used_memory_size();
+  snapshot.paged_in_count = memory_manager_->get_paged_in_count();
+  snapshot.paged_out_count = memory_manager_->get_paged_out_count();
+
+  CoreStats core_stats = get_core_stats();
+
+  snapshot.total_cpu_ticks = core_stats.active_ticks + core_stats.idle_ticks;
+  snapshot.idle_cpu_ticks = core_stats.idle_ticks;
+  snapshot.active_cpu_ticks = core_stats.active_ticks;
+
+  stats_snapshot_.store(spare_snapshot_, std::memory_order_release);
+  std::swap(spare_snapshot_, published_snapshot_);
+}
+
+// cores run in parallel, so a cycle lasts as long as its slowest core
+// a single timer per cycle replaces every core spinning for its delay
+void Emulator::pace_cycle(std::stop_token st) {
+  uint64_t delay = 0;
+
+  for (auto &core : cores_)
+    delay = std::max(delay, core.take_virtual_delay());
+
+  if (delay == 0)
+    return;
+
+  auto now = std::chrono::steady_clock::now();
+
+  // catch up on small oversleeps, but never burst after a long stall
+  cycle_deadline_ =
+      std::max(cycle_deadline_, now - std::chrono::milliseconds(10));
+  cycle_deadline_ += std::chrono::microseconds(delay);
+
+  if (cycle_deadline_ <= now)
+    return;
+
+  std::unique_lock<std::mutex> lock(mtx_);
+  wake_cv_.wait_until(lock, st, cycle_deadline_, [] { return false; });
+}
+
+// per-core counters summed on read
+CoreStats Emulator::get_core_stats() const {
+  CoreStats total;
+
+  for (const auto &core : cores_)
+    total += core.get_stats();
+
+  return total;
 }
 
 void Emulator::initialize() {
   if (is_initialized_)
     throw std::runtime_error("Emulator is already initialized.");
 
-  std::string config_file = "config.txt";
+  setup("config.txt");
+  start_cycle_thread();
+}
 
+void Emulator::setup(const std::string &config_file) {
   if (!config_.load(config_file))
     throw std::runtime_error("Configuration not loaded.");
 
+  // seed 0 = pick a fresh seed for every run
+  uint64_t seed = config_.get_random_seed();
+
+  Random::set_seed(seed != 0 ? seed
+                             : static_cast<uint64_t>(
+                                   std::chrono::system_clock::now()
+                                       .time_since_epoch()
+                                       .count()));
+
   for (int i = 0; i < config_.get_num_cpu(); ++i) {
     cores_.emplace_back(i, config_.get_scheduler(),
-                        config_.get_delay_per_exec());
+                        config_.get_delay_per_exec(),
+                        config_.get_delay_mode() == "virtual",
+                        config_.get_fuse_instructions() == "on");
   }
 
+  // quantum mode lets each core run a whole quantum per cycle and only
+  // synchronize with the scheduler at dispatch boundaries
+  if (config_.get_execution_mode() == "quantum")
+    ticks_per_cycle_ = std::max(1u, config_.get_quantum_cycles());
+
   std::string scheduler = config_.get_scheduler();
-  scheduler_ = SchedulerFactory::create_scheduler(scheduler,
-                                                  config_.get_quantum_cycles());
+  scheduler_ = SchedulerFactory::create_scheduler(
+      scheduler, config_.get_quantum_cycles(), config_.get_num_cpu());
 
   memory_manager_ = std::make_unique<MemoryManager>(
       config_.get_max_overall_mem(), config_.get_mem_per_frame(),
       "csopesy-backing-store.txt");
 
+  writer_ = std::make_unique<AsyncWriter>();
+
+  if (config_.get_log_spill() == "on")
+    log_segment_ =
+        std::make_unique<LogSegment>("csopesy-log-segment.txt", *writer_);
+
+  start_core_workers();
+  publish_stats_snapshot();
+
   is_initialized_ = true;
+}
+
+void Emulator::start_cycle_thread() {
   cycle_thread_ = std::jthread([this](std::stop_token st) { cycle(st); });
+
+  if (placement_.cycle_cpu >= 0 &&
+      !Affinity::pin_thread(cycle_thread_.native_handle(),
+                            placement_.cycle_cpu))
+    std::cerr << "Failed to pin cycle thread to host cpu "
+              << placement_.cycle_cpu << std::endl;
 }
 
 void Emulator::exit() {
@@ -365,31 +804,23 @@ void Emulator::start_screen(std::vector<std::string> &args) {
   std::string process_name = args[1];
   uint32_t memory_size = std::stoul(args[2]);
 
+  std::unique_lock<std::mutex> processes_lock(processes_mutex_);
+
   auto [it, inserted] = processes_.try_emplace(process_name, nullptr);
 
   if (inserted) {
-    int num_instructions =
-        config_.get_min_ins() +
-        (rand() % (config_.get_max_ins() - config_.get_min_ins() + 1));
+    RandomStream rng = Random::stream(Random::Domain::SCREEN, process_name);
 
-    /* std::vector<std::unique_ptr<IInstruction>> instructions =
-        InstructionFactory::create_instructions(process_name,
-       num_instructions, config_.get_max_ins(), config_.get_min_ins());
-    */
-
-    /*
-    std::vector<std::unique_ptr<IInstruction>> instructions =
-        InstructionFactory::create_mo1_demo_instructions(process_name,
-                                                         num_instructions);
-    */
-
-    std::vector<std::unique_ptr<IInstruction>> instructions =
-        InstructionFactory::create_hardcoded_instructions(process_name);
+    int num_instructions =
+        rng.next_in_range(config_.get_min_ins(), config_.get_max_ins());
 
     std::unique_ptr<Process> new_process = std::make_unique<Process>(
         process_name, num_instructions, config_.get_quantum_cycles());
 
-    new_process->set_instructions(std::move(instructions));
+    new_process->set_log_buffer(config_.get_log_buffer_size(),
+                                log_segment_.get());
+
+    load_program(*new_process, num_instructions, rng);
 
     it->second = std::move(new_process);
   }
@@ -398,46 +829,88 @@ void Emulator::start_screen(std::vector<std::string> &args) {
 
   process->set_state(Process::ProcessState::READY);
 
-  current_process_ = processes_[process_name].get();
+  current_process_ = process;
+
+  processes_lock.unlock();
 
   if (memory_manager_) {
     memory_manager_->register_process(current_process_, memory_size,
                                       config_.get_mem_per_frame());
   }
 
-  scheduler_->add_process(current_process_);
+  submit_process(current_process_);
 
   std::cout << "\033[2J\033[1;1H";
 }
 
 void Emulator::list_screens() {
-  // wait for cpu cycle to finish for accurate report
-  {
-    std::unique_lock<std::mutex> lock(mtx_);
-    cv_.wait(lock, [this] { return cycle_finished_; });
-    cycle_finished_ = false;
-  }
   // does the same as report_util but doesnt log to a file
-  log_cpu_util_report(std::cout);
+  log_cpu_util_report(std::cout, *stats_snapshot_.load());
 }
 
+// screen -r <name> [page], page 1 holds the newest logs and older pages
+// reach back into the spilled logs
 void Emulator::resume_screen(std::vector<std::string> &args) {
   if (args.size() < 2)
     throw std::runtime_error("No process name provided for -r command.");
 
   std::string process_name = args[1];
+  uint64_t page = args.size() > 2 ? std::stoull(args[2]) : 1;
 
-  auto it = processes_.find(process_name);
+  Process *process = nullptr;
 
-  if (it == processes_.end()) {
-    std::string error_msg = "Process " + process_name + " not found.";
-    throw std::runtime_error(error_msg);
-    return;
+  // processes are never erased, so the pointer outlives the lock and reading
+  // spilled logs does not hold up the cycle thread
+  {
+    std::lock_guard<std::mutex> lock(processes_mutex_);
+
+    auto it = processes_.find(process_name);
+
+    if (it == processes_.end()) {
+      std::string error_msg = "Process " + process_name + " not found.";
+      throw std::runtime_error(error_msg);
+      return;
+    }
+
+    process = it->second.get();
   }
 
-  current_process_ = it->second.get();
+  uint64_t first_log = process->get_first_log();
+  uint64_t log_count = process->get_log_count();
+  uint64_t page_count =
+      std::max<uint64_t>(1, (log_count - first_log + LOG_PAGE_SIZE - 1) /
+                                LOG_PAGE_SIZE);
+
+  if (page < 1 || page > page_count)
+    throw std::runtime_error("Page " + args[2] + " out of range, " +
+                             std::to_string(page_count) + " pages of logs.");
+
+  uint64_t last_page_log = log_count - (page - 1) * LOG_PAGE_SIZE;
+  uint64_t first_page_log = last_page_log > first_log + LOG_PAGE_SIZE
+                                ? last_page_log - LOG_PAGE_SIZE
+                                : first_log;
+
+  current_process_ = process;
+
+  // logs are stored raw and only formatted here
+  std::string logs =
+      current_process_->format_logs(first_page_log, last_page_log);
 
   std::cout << "\033[2J\033[1;1H";
+  std::cout << "Process name: " << current_process_->get_name() << "\n";
+  std::cout << "ID: " << current_process_->get_id() << "\n";
+  std::cout << "Logs (page " << page << " of " << page_count << "):\n"
+            << logs << "\n";
+
+  if (current_process_->get_state() == Process::ProcessState::TERMINATED) {
+    std::cout << "Finished!" << std::endl;
+    return;
+  }
+
+  std::cout << "Current instruction line: "
+            << current_process_->get_instruction_pointer() << "\n";
+  std::cout << "Lines of code: " << current_process_->get_total_instructions()
+            << std::endl;
 }
 
 void Emulator::custom_screen(std::vector<std::string> &args) {
@@ -448,33 +921,51 @@ void Emulator::custom_screen(std::vector<std::string> &args) {
   uint32_t memory_size = std::stoul(args[2]);
   std::string instructions_str = args[3];
 
-  if (processes_.find(process_name) != processes_.end()) {
-    std::string error_msg = "Process " + process_name + " already exists.";
-    throw std::runtime_error(error_msg);
-    return;
+  {
+    std::lock_guard<std::mutex> lock(processes_mutex_);
+
+    if (processes_.find(process_name) != processes_.end()) {
+      std::string error_msg = "Process " + process_name + " already exists.";
+      throw std::runtime_error(error_msg);
+      return;
+    }
   }
 
-  std::vector<std::unique_ptr<IInstruction>> instructions =
-      InstructionFactory::create_instructions_from_string(instructions_str);
+  // the same source text always compiles to the same program
+  std::shared_ptr<const Program> program = program_cache_.get_or_build(
+      "source:" + instructions_str, [&instructions_str] {
+        std::vector<std::unique_ptr<IInstruction>> instructions =
+            InstructionFactory::create_instructions_from_string(
+                instructions_str);
 
-  if (instructions.empty() || instructions.size() > 50) {
-    throw std::runtime_error(
-        "Custom process must have between 1 and 50 instructions.");
-  }
+        if (instructions.empty() || instructions.size() > 50) {
+          throw std::runtime_error(
+              "Custom process must have between 1 and 50 instructions.");
+        }
+
+        return Program::compile(instructions);
+      });
 
   std::unique_ptr<Process> process = std::make_unique<Process>(
-      process_name, static_cast<int>(instructions.size()),
+      process_name, static_cast<int>(program->size()),
       config_.get_quantum_cycles());
 
-  process->set_instructions(std::move(instructions));
+  process->set_program(std::move(program));
+  process->set_log_buffer(config_.get_log_buffer_size(), log_segment_.get());
 
   if (memory_manager_) {
     memory_manager_->register_process(process.get(), memory_size,
                                       config_.get_mem_per_frame());
   }
 
-  processes_[process_name] = std::move(process);
-  scheduler_->add_process(processes_[process_name].get());
+  Process *new_process = process.get();
+
+  {
+    std::lock_guard<std::mutex> lock(processes_mutex_);
+    processes_[process_name] = std::move(process);
+  }
+
+  submit_process(new_process);
 }
 
 void Emulator::scheduler_start() {
@@ -484,7 +975,12 @@ void Emulator::scheduler_start() {
   if (scheduler_ && scheduler_->is_running())
     throw std::runtime_error("Scheduler is already running.");
 
-  scheduler_->start();
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    scheduler_->start();
+  }
+
+  wake_cv_.notify_one();
 
   std::cout << "Scheduler started." << std::endl;
 }
@@ -502,91 +998,72 @@ void Emulator::report_util() {
   if (!is_initialized_)
     throw std::runtime_error("Emulator is not initialized.");
 
-  // wait for cpu cycle to finish for accurate report
-  {
-    std::unique_lock<std::mutex> lock(mtx_);
-    cv_.wait(lock, [this] { return cycle_finished_; });
-    cycle_finished_ = false;
-  }
+  // latest published cycle, no need to wait for the cycle thread
+  std::shared_ptr<const StatsSnapshot> snapshot = stats_snapshot_.load();
 
-  std::ofstream report_file("csopesy-log.txt");
+  if (report_file_ < 0)
+    report_file_ = writer_->open("csopesy-log.txt", true);
 
-  if (!report_file.is_open())
-    throw std::runtime_error("Failed to open report file.");
+  // formatted once, the file copy is written in the background
+  std::ostringstream report;
+  log_cpu_util_report(report, *snapshot);
 
-  int busy_cores = 0;
+  std::string report_text = report.str();
+  std::cout << report_text;
+  writer_->replace(report_file_, std::move(report_text));
+}
 
-  for (const auto &core : cores_) {
-    if (!core.is_idle())
-      busy_cores++;
-  }
+// waits until every report and spilled log is on disk
+void Emulator::flush() {
+  if (!is_initialized_)
+    throw std::runtime_error("Emulator is not initialized.");
 
-  log_cpu_util_report(std::cout);
-  log_cpu_util_report(report_file);
+  writer_->flush();
 
-  report_file.close();
+  std::cout << "All pending output written." << std::endl;
 }
 
-void Emulator::log_cpu_util_report(std::ostream &output_stream) {
-  int busy_cores = 0;
+void Emulator::log_cpu_util_report(std::ostream &output_stream,
+                                   const StatsSnapshot &snapshot) {
+  int busy_cores = snapshot.running_processes.size();
+  int num_cores = snapshot.num_cores;
 
-  for (const auto &core : cores_) {
-    if (!core.is_idle())
-      busy_cores++;
-  }
-
-  int cpu_utilization = cores_.empty() ? 0 : (busy_cores * 100) / cores_.size();
+  int cpu_utilization = num_cores == 0 ? 0 : (busy_cores * 100) / num_cores;
 
   // output_stream << "CPU utilization: " << cpu_utilization << "%\n";
   output_stream << "CPU utilization: "
-                << (scheduler_->is_running() ? cpu_utilization : 0) << "%\n";
+                << (snapshot.is_scheduler_running ? cpu_utilization : 0)
+                << "%\n";
 
   // output_stream << "Cores used: " << busy_cores << "\n";
   //
-  output_stream << "Cores used: " << (scheduler_->is_running() ? busy_cores : 0)
-                << "\n";
+  output_stream << "Cores used: "
+                << (snapshot.is_scheduler_running ? busy_cores : 0) << "\n";
 
-  // output_stream << "Cores available: " << cores_.size() - busy_cores <<
+  // output_stream << "Cores available: " << num_cores - busy_cores <<
   // "\n\n";
   output_stream << "Cores available: "
-                << (scheduler_->is_running() ? cores_.size() - busy_cores : 0)
+                << (snapshot.is_scheduler_running ? num_cores - busy_cores : 0)
                 << "\n\n";
   output_stream << "----------------------------------------\n";
   output_stream << "Running processes:\n";
 
   bool any_running = false;
 
-  auto format_process_log = [](const Process *process, int core_id) {
-    std::string core_info =
-        core_id < 0 ? "Finished" : "Core: " + std::to_string(core_id);
-    return process->get_name() + "  " + "(" + process->get_created_at() +
-           ")  " + core_info + "  " +
-           std::to_string(process->get_instruction_pointer()) + "/" +
-           std::to_string(process->get_total_instructions()) + "\n";
+  auto format_process_log = [](const StatsSnapshot::ProcessEntry &entry) {
+    std::string core_info = entry.core_id < 0
+                                ? "Finished"
+                                : "Core: " + std::to_string(entry.core_id);
+    return entry.process->get_name() + "  " + "(" +
+           entry.process->get_created_at() + ")  " + core_info + "  " +
+           std::to_string(entry.instruction_pointer) + "/" +
+           std::to_string(entry.total_instructions) + "\n";
   };
 
-  /* for (size_t i = 0; i < cores_.size(); ++i) {
-    if (!cores_[i].is_idle()) {
-      const Process *running_process = cores_[i].get_current_process();
-      if (!running_process)
-        continue;
-
+  if (snapshot.is_scheduler_running) {
+    for (const auto &entry : snapshot.running_processes) {
       any_running = true;
-      output_stream << format_process_log(running_process, i);
-    }
-  }
-  */
-
-  if (scheduler_->is_running()) {
-    for (size_t i = 0; i < cores_.size(); ++i) {
-      if (!cores_[i].is_idle()) {
-        const Process *running_process = cores_[i].get_current_process();
-        if (!running_process)
-          continue;
-
-        any_running = true;
-        output_stream << format_process_log(running_process, i);
-      }
+      output_stream << format_process_log(entry);
     }
   }
 
@@ -597,24 +1074,13 @@ void Emulator::log_cpu_util_report(std::ostream &output_stream) {
 
   output_stream << "Finished processes:\n";
 
-  if (terminated_processes_.empty()) {
+  if (snapshot.finished_processes.empty()) {
     output_stream << "No finished processes.\n";
   } else {
-
-    /* for (const auto &finished_process : terminated_processes_) {
-      output_stream << format_process_log(finished_process, -1);
-    }
-    */
-
-    // used to limit log output to first 10 entries to avoid bloating the
+    // snapshot only keeps the first 10 entries to avoid bloating the
     // file/screen
-    int loop_count =
-        terminated_processes_.size() <= 10 ? terminated_processes_.size() : 10;
-
-    for (int i = 0; i < loop_count; ++i) {
-      const auto &finished_process = terminated_processes_[i];
-      output_stream << format_process_log(finished_process, -1);
-    }
+    for (const auto &entry : snapshot.finished_processes)
+      output_stream << format_process_log(entry);
   }
 
   output_stream << "----------------------------------------\n\n";
@@ -624,28 +1090,20 @@ void Emulator::process_smi() {
   if (!is_initialized_)
     throw std::runtime_error("Emulator is not initialized.");
 
-  // Wait for the current cycle to finish to ensure we get a consistent report
-  {
-    std::unique_lock<std::mutex> lock(mtx_);
-    cv_.wait(lock, [this] { return cycle_finished_; });
-    cycle_finished_ = false;
-  }
+  // latest published cycle, no need to wait for the cycle thread
+  std::shared_ptr<const StatsSnapshot> snapshot = stats_snapshot_.load();
 
   // 1. Calculate CPU Utilization
-  int busy_cores = 0;
-  for (const auto &core : cores_) {
-    if (!core.is_idle()) {
-      busy_cores++;
-    }
-  }
+  int busy_cores = snapshot->running_processes.size();
 
   // Avoid division by zero if no cores (unlikely if initialized)
-  int cpu_utilization = cores_.empty() ? 0 : (busy_cores * 100) / cores_.size();
+  int cpu_utilization = snapshot->num_cores == 0
+                            ? 0
+                            : (busy_cores * 100) / snapshot->num_cores;
 
   // 2. Calculate Memory Usage
-  // We use the MemoryManager to get accurate stats
-  uint32_t total_mem = memory_manager_->get_total_memory_size();
-  uint32_t used_mem = memory_manager_->get_used_memory_size();
+  uint32_t total_mem = snapshot->total_memory_size;
+  uint32_t used_mem = snapshot->used_memory_size;
 
   // Calculate percentage, utilizing uint64_t for multiplication to prevent
   // overflow
@@ -664,32 +1122,12 @@ void Emulator::process_smi() {
   std::cout << "--------------------------------------------" << std::endl;
 
   // 4. List Processes and their Memory Usage
-  // Get the map of pid -> bytes used from MemoryManager
-  std::unordered_map<int, uint32_t> process_mem_usage =
-      memory_manager_->get_all_processes_memory_usage();
-
-  // show running processes
-  bool has_running_processes = false;
-
-  for (auto &core : cores_) {
-    if (!core.is_idle()) {
-      Process *process = core.get_current_process();
-      if (process) {
-        has_running_processes = true;
-        int pid = process->get_id();
-        uint32_t mem_used = 0;
-
-        auto mem_it = process_mem_usage.find(pid);
-        if (mem_it != process_mem_usage.end()) {
-          mem_used = mem_it->second;
-        }
-
-        std::cout << process->get_name() << " " << mem_used << "B" << std::endl;
-      }
-    }
+  for (const auto &entry : snapshot->running_processes) {
+    std::cout << entry.process->get_name() << " " << entry.memory_used << "B"
+              << std::endl;
   }
 
-  if (!has_running_processes) {
+  if (snapshot->running_processes.empty()) {
     std::cout << "No running processes." << std::endl;
   }
 
@@ -700,29 +1138,21 @@ void Emulator::vmstat() {
   if (!is_initialized_)
     throw std::runtime_error("Emulator is not initialized.");
 
-  // wait for cpu cycle to finish for accurate report
-  {
-    std::unique_lock<std::mutex> lock(mtx_);
-    cv_.wait(lock, [this] { return cycle_finished_; });
-    cycle_finished_ = false;
-  }
+  // latest published cycle, no need to wait for the cycle thread
+  std::shared_ptr<const StatsSnapshot> snapshot = stats_snapshot_.load();
 
   // memory stats
-  uint32_t total_mem_size = memory_manager_->get_total_memory_size();
-  uint32_t used_mem_size = memory_manager_->get_used_memory_size();
-  uint32_t free_mem_size = memory_manager_->get_free_memory_size();
-
-  // paging stats
-  uint64_t paged_in_count = memory_manager_->get_paged_in_count();
-  uint64_t paged_out_count = memory_manager_->get_paged_out_count();
+  uint32_t total_mem_size = snapshot->total_memory_size;
+  uint32_t used_mem_size = snapshot->used_memory_size;
+  uint32_t free_mem_size = total_mem_size - used_mem_size;
 
   // display vmstat output
   std::cout << "Total Memory: " << total_mem_size << " bytes" << std::endl;
   std::cout << "Used Memory: " << used_mem_size << " bytes" << std::endl;
   std::cout << "Free Memory: " << free_mem_size << " bytes" << std::endl;
-  std::cout << "Idle CPU Ticks: " << idle_cpu_ticks_ << std::endl;
-  std::cout << "Active CPU Ticks: " << active_cpu_ticks_ << std::endl;
-  std::cout << "Total CPU Ticks: " << total_cpu_ticks_ << std::endl;
-  std::cout << "Num paged in: " << paged_in_count << std::endl;
-  std::cout << "Num paged out: " << paged_out_count << std::endl;
+  std::cout << "Idle CPU Ticks: " << snapshot->idle_cpu_ticks << std::endl;
+  std::cout << "Active CPU Ticks: " << snapshot->active_cpu_ticks << std::endl;
+  std::cout << "Total CPU Ticks: " << snapshot->total_cpu_ticks << std::endl;
+  std::cout << "Num paged in: " << snapshot->paged_in_count << std::endl;
+  std::cout << "Num paged out: " << snapshot->paged_out_count << std::endl;
 }
@@ -0,0 +1,66 @@
+#include "LogSegment.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+LogSegment::LogSegment(const std::string &filename, AsyncWriter &writer)
+    : writer_(writer), fd_(writer.open(filename, true)) {}
+
+int64_t LogSegment::append(int64_t previous_batch, uint64_t first_log,
+                           const ProcessLog *logs, uint32_t count) {
+  BatchHeader header{.previous_batch = previous_batch,
+                     .first_log = first_log,
+                     .count = count};
+
+  std::string batch_data(sizeof(header) + sizeof(ProcessLog) * count, '\0');
+  std::memcpy(batch_data.data(), &header, sizeof(header));
+  std::memcpy(batch_data.data() + sizeof(header), logs,
+              sizeof(ProcessLog) * count);
+
+  int64_t batch = end_.fetch_add(batch_data.size(), std::memory_order_relaxed);
+  writer_.write_at(fd_, batch, std::move(batch_data));
+
+  return batch;
+}
+
+std::vector<ProcessLog> LogSegment::read(int64_t batch, uint64_t first_log,
+                                         uint64_t last_log) {
+  std::vector<ProcessLog> logs;
+
+  if (first_log >= last_log)
+    return logs;
+
+  logs.resize(last_log - first_log);
+
+  // batches may still be queued on the writer
+  writer_.drain();
+
+  // walk back from the newest batch until the range is covered
+  while (batch >= 0) {
+    BatchHeader header;
+
+    if (::pread(fd_, &header, sizeof(header), batch) != sizeof(header))
+      throw std::runtime_error("Failed to read from log segment.");
+
+    uint64_t start = std::max(first_log, header.first_log);
+    uint64_t end = std::min(last_log, header.first_log + header.count);
+
+    if (start < end) {
+      size_t size = sizeof(ProcessLog) * (end - start);
+      off_t offset = batch + sizeof(header) +
+                     sizeof(ProcessLog) * (start - header.first_log);
+
+      if (::pread(fd_, &logs[start - first_log], size, offset) !=
+          static_cast<ssize_t>(size))
+        throw std::runtime_error("Failed to read from log segment.");
+    }
+
+    if (header.first_log <= first_log)
+      break;
+
+    batch = header.previous_batch;
+  }
+
+  return logs;
+}
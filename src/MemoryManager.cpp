@@ -21,17 +21,34 @@ MemoryManager::MemoryManager(uint32_t max_overall_mem, uint32_t mem_per_frame,
 
 MemoryAccessResult MemoryManager::read(uint32_t virtual_address,
                                        Process *process, uint16_t &out_value) {
-  std::lock_guard<std::mutex> lock(memory_mutex_);
-
   // calculate virtual page number and offset
   uint32_t virtual_page_number = virtual_address / mem_per_frame_;
   uint32_t offset = virtual_address % mem_per_frame_;
 
+  // page table size is fixed once the process is registered
   if (virtual_page_number >= process->get_page_table_size()) {
     out_value = 0;
     return MemoryAccessResult::ACCESS_VIOLATION;
   }
 
+  // resident page, translate without the lock
+  if (process->pin_page_table()) {
+    const PageTableEntry &page_table_entry =
+        process->get_page_table_entry(virtual_page_number);
+
+    if (page_table_entry.valid_bit) {
+      MemoryAccessResult result =
+          load(page_table_entry.frame_number, offset, out_value);
+      process->unpin_page_table();
+
+      return result;
+    }
+
+    process->unpin_page_table();
+  }
+
+  std::lock_guard<std::mutex> lock(memory_mutex_);
+
   // get page table entry
   const PageTableEntry &page_table_entry =
       process->get_page_table_entry(virtual_page_number);
@@ -42,24 +59,11 @@ MemoryAccessResult MemoryManager::read(uint32_t virtual_address,
     paged_in_count_++;
   }
 
-  uint32_t physical_address =
-      page_table_entry.frame_number * mem_per_frame_ + offset;
-
-  if (physical_address + sizeof(uint16_t) > physical_memory_.size()) {
-    out_value = 0;
-    return MemoryAccessResult::ERROR;
-  }
-
-  out_value =
-      *reinterpret_cast<uint16_t *>(&physical_memory_[physical_address]);
-
-  return MemoryAccessResult::SUCCESS;
+  return load(page_table_entry.frame_number, offset, out_value);
 }
 
 MemoryAccessResult MemoryManager::write(uint32_t virtual_address,
                                         Process *process, uint16_t value) {
-  std::lock_guard<std::mutex> lock(memory_mutex_);
-
   // calculate virtual page number and offset
   uint32_t virtual_page_number = virtual_address / mem_per_frame_;
   uint32_t offset = virtual_address % mem_per_frame_;
@@ -68,6 +72,28 @@ MemoryAccessResult MemoryManager::write(uint32_t virtual_address,
     return MemoryAccessResult::ACCESS_VIOLATION;
   }
 
+  // resident page, translate without the lock
+  if (process->pin_page_table()) {
+    PageTableEntry &page_table_entry =
+        process->get_page_table_entry(virtual_page_number);
+
+    if (page_table_entry.valid_bit) {
+      MemoryAccessResult result =
+          store(page_table_entry.frame_number, offset, value);
+
+      if (result == MemoryAccessResult::SUCCESS)
+        page_table_entry.dirty_bit = true;
+
+      process->unpin_page_table();
+
+      return result;
+    }
+
+    process->unpin_page_table();
+  }
+
+  std::lock_guard<std::mutex> lock(memory_mutex_);
+
   PageTableEntry &page_table_entry =
       process->get_page_table_entry(virtual_page_number);
 
@@ -76,15 +102,41 @@ MemoryAccessResult MemoryManager::write(uint32_t virtual_address,
     paged_in_count_++;
   }
 
-  uint32_t physical_address =
-      page_table_entry.frame_number * mem_per_frame_ + offset;
+  MemoryAccessResult result =
+      store(page_table_entry.frame_number, offset, value);
+
+  if (result == MemoryAccessResult::SUCCESS)
+    page_table_entry.dirty_bit = true;
+
+  return result;
+}
+
+// frames of a pinned or locked page table belong to the caller, so the bytes
+// need no further synchronization
+MemoryAccessResult MemoryManager::load(int frame_number, uint32_t offset,
+                                       uint16_t &out_value) {
+  uint32_t physical_address = frame_number * mem_per_frame_ + offset;
+
+  if (physical_address + sizeof(uint16_t) > physical_memory_.size()) {
+    out_value = 0;
+    return MemoryAccessResult::ERROR;
+  }
+
+  out_value =
+      *reinterpret_cast<uint16_t *>(&physical_memory_[physical_address]);
+
+  return MemoryAccessResult::SUCCESS;
+}
+
+MemoryAccessResult MemoryManager::store(int frame_number, uint32_t offset,
+                                        uint16_t value) {
+  uint32_t physical_address = frame_number * mem_per_frame_ + offset;
 
   if (physical_address + sizeof(uint16_t) > physical_memory_.size()) {
     return MemoryAccessResult::ERROR;
   }
 
   reinterpret_cast<uint16_t *>(&physical_memory_[physical_address])[0] = value;
-  page_table_entry.dirty_bit = true;
 
   return MemoryAccessResult::SUCCESS;
 }
@@ -116,6 +168,7 @@ void MemoryManager::remove_process(int process_id) {
       frame_entry.is_allocated = false;
       frame_entry.owner_process_id = -1;
       frame_entry.virtual_page_number = -1;
+      used_frames_--;
 
       free_frame_list_.push(&frame_entry - &frame_table_[0]); // frame index
     }
@@ -123,6 +176,7 @@ void MemoryManager::remove_process(int process_id) {
 
   auto it = processes_.find(process_id);
   if (it != processes_.end()) {
+    it->second->clear_resident_pages();
     processes_.erase(it);
   }
 }
@@ -139,16 +193,7 @@ uint32_t MemoryManager::get_total_memory_size() const {
 
 uint32_t MemoryManager::get_used_memory_size() const {
   std::lock_guard<std::mutex> lock(memory_mutex_);
-
-  uint32_t used_frames = 0;
-
-  for (const auto &frame_entry : frame_table_) {
-    if (frame_entry.is_allocated) {
-      used_frames++;
-    }
-  }
-
-  return used_frames * mem_per_frame_;
+  return used_frames_ * mem_per_frame_;
 }
 
 uint32_t MemoryManager::get_free_memory_size() const {
@@ -217,10 +262,14 @@ void MemoryManager::page_fault(Process *process, uint32_t virtual_page_number) {
     frame_number = get_victim_frame();
   }
 
+  if (!frame_table_[frame_number].is_allocated)
+    used_frames_++;
+
   // allocate frame
   frame_table_[frame_number].is_allocated = true;
   frame_table_[frame_number].owner_process_id = process->get_id();
   frame_table_[frame_number].virtual_page_number = virtual_page_number;
+  process->add_resident_pages(1);
 
   read_page_from_backing_store(process, virtual_page_number, frame_number);
 
@@ -253,6 +302,9 @@ int MemoryManager::get_victim_frame() {
       Process *owner_process = it->second;
 
       if (virtual_page_number < owner_process->get_page_table_size()) {
+        // the owner may be running on another core
+        owner_process->lock_page_table();
+
         auto &page_table_entry =
             owner_process->get_page_table_entry(virtual_page_number);
 
@@ -265,13 +317,18 @@ int MemoryManager::get_victim_frame() {
         page_table_entry.valid_bit = false;
         page_table_entry.dirty_bit = false;
         page_table_entry.frame_number = -1;
+
+        owner_process->unlock_page_table();
       }
+
+      owner_process->add_resident_pages(-1);
     }
 
     // clear frame table entry
     frame_table_[victim_frame].is_allocated = false;
     frame_table_[victim_frame].owner_process_id = -1;
     frame_table_[victim_frame].virtual_page_number = -1;
+    used_frames_--;
   }
 
   return victim_frame;
@@ -1,54 +1,51 @@
 #include "Process.hpp"
+#include "LogSegment.hpp"
 #include "MemoryManager.hpp"
+#include "instructions/ExecutionContext.hpp"
+#include <algorithm>
+#include <thread>
 
 // auto inc process id
 int Process::next_id_ = 0;
 
+namespace {
+
+// shared by processes that have not been given a program yet
+const std::shared_ptr<const Program> &empty_program() {
+  static const std::shared_ptr<const Program> program =
+      std::make_shared<const Program>();
+  return program;
+}
+
+} // namespace
+
 Process::Process(const std::string &name, int total_instructions,
                  int quantum_cycles)
-    : id_(next_id_++), name_(name), total_instructions_(total_instructions),
-      state_(ProcessState::NEW), quantum_remaining_(quantum_cycles) {
-  symbol_table_["x"] = 0; // required for mo1 demo
-}
+    : id_(next_id_++), name_(name), program_(empty_program()),
+      total_instructions_(total_instructions), state_(ProcessState::NEW),
+      quantum_remaining_(quantum_cycles) {}
 
 void Process::execute_current_instruction(int cpu_core_id,
-                                          MemoryManager *memory_manager) {
-  if (instruction_pointer_ < instructions_.size()) {
-    instructions_[instruction_pointer_]->execute(
-        {.add_log =
-             [this, cpu_core_id](const std::string &message) {
-               this->add_log(cpu_core_id, message);
-             },
-         .get_variable =
-             [this, memory_manager](const std::string &var_name) {
-               return this->get_variable(var_name, memory_manager);
-             },
-         .add_variable =
-             [this, memory_manager](std::pair<std::string, uint16_t> var) {
-               this->add_variable(var, memory_manager);
-             },
-         .add_instructions =
-             [this](std::vector<std::unique_ptr<IInstruction>>
-                        &&new_instructions) {
-               this->add_instructions(std::move(new_instructions));
-             },
-         .sleep = [this](int ticks) { this->sleep(ticks); },
-         .read_from_address =
-             [this, memory_manager](uint32_t address) {
-               return this->read_from_address(address, memory_manager);
-             },
-         .write_to_address =
-             [this, memory_manager](uint32_t address, uint16_t value) {
-               this->write_to_address(address, value, memory_manager);
-             }});
+                                          MemoryManager *memory_manager,
+                                          int width) {
+  if (fetch()) {
+    ExecutionContext context(*this, memory_manager, cpu_core_id);
+    get_program().execute(program_counter_, context, width);
   }
 }
 
+// instructions the next dispatch may run, never more than max_width
+int Process::get_instruction_width(int max_width) const {
+  return get_program().get_width(program_counter_, max_width);
+}
+
 const int Process::get_id() const { return id_; }
 
 const std::string Process::get_name() const { return name_; }
 
-const std::string Process::get_created_at() const { return created_at_; }
+const std::string Process::get_created_at() const {
+  return Clock::format(created_at_);
+}
 
 const int Process::get_total_instructions() const {
   return total_instructions_;
@@ -64,6 +61,8 @@ const int Process::is_quantum_expired() const {
   return quantum_remaining_ <= 0;
 }
 
+const int Process::get_quantum_remaining() const { return quantum_remaining_; }
+
 const int Process::get_page_table_size() const { return page_table_.size(); }
 
 const PageTableEntry &
@@ -85,18 +84,73 @@ const uint32_t Process::get_backing_store_offset() const {
 
 const bool Process::get_access_violation() const { return access_violation_; }
 
-void Process::increment_instruction_pointer() {
-  if (instruction_pointer_ < instructions_.size())
-    instruction_pointer_++;
-  if (instruction_pointer_ >= instructions_.size()) {
-    state_ = ProcessState::TERMINATED;
-    total_instructions_ = instructions_.size();
+const int Process::get_sleep_ticks() const { return sleep_ticks_; }
+
+const uint32_t Process::get_resident_pages() const {
+  return resident_pages_.load(std::memory_order_relaxed);
+}
+
+void Process::increment_instruction_pointer(int count) {
+  for (int i = 0; i < count; ++i) {
+    if (program_counter_ < get_program().size()) {
+      program_counter_++;
+      instruction_pointer_++;
+    }
+
+    // jump back at the end of a loop body, nested loops can end together
+    while (loop_depth_ > 0 &&
+           program_counter_ == loop_stack_[loop_depth_ - 1].body_end) {
+      LoopFrame &frame = loop_stack_[loop_depth_ - 1];
+
+      if (--frame.repeats_left > 0) {
+        program_counter_ = frame.body_start;
+        break;
+      }
+
+      loop_depth_--;
+    }
+
+    if (!fetch()) {
+      state_ = ProcessState::TERMINATED;
+      total_instructions_ = instruction_pointer_;
+    }
   }
 }
 
 void Process::set_instructions(
     std::vector<std::unique_ptr<IInstruction>> &&instructions) {
-  instructions_ = std::move(instructions);
+  program_ = std::make_shared<const Program>(Program::compile(instructions));
+}
+
+void Process::set_program(std::shared_ptr<const Program> program) {
+  program_ = std::move(program);
+}
+
+void Process::set_instruction_stream(
+    std::unique_ptr<InstructionStream> stream) {
+  stream_ = std::move(stream);
+  program_counter_ = 0;
+}
+
+// only before the process runs, spilling works in whole batches so the ring
+// is rounded up to a multiple of one
+void Process::set_log_buffer(uint32_t capacity, LogSegment *log_segment) {
+  capacity = std::max(capacity, 1u);
+
+  // whole batches, rounded in 64 bits and kept within uint32_t
+  if (log_segment) {
+    uint64_t batches = (static_cast<uint64_t>(capacity) +
+                        LogSegment::BATCH_SIZE - 1) /
+                       LogSegment::BATCH_SIZE;
+
+    capacity = static_cast<uint32_t>(
+        std::min<uint64_t>(batches * LogSegment::BATCH_SIZE,
+                           UINT32_MAX / LogSegment::BATCH_SIZE *
+                               LogSegment::BATCH_SIZE));
+  }
+
+  logs_capacity_ = capacity;
+  log_segment_ = log_segment;
 }
 
 void Process::set_state(ProcessState state) { state_ = state; }
@@ -105,13 +159,13 @@ void Process::set_quantum_remaining(int quantum_cycles) {
   quantum_remaining_ = quantum_cycles;
 }
 
-void Process::decrement_quantum_remaining() { quantum_remaining_--; }
+void Process::decrement_quantum_remaining(int ticks) {
+  quantum_remaining_ -= ticks;
+}
 
-void Process::decrement_sleep_ticks() {
-  if (sleep_ticks_ > 0)
-    sleep_ticks_--;
-  else
-    state_ = ProcessState::READY;
+void Process::wake() {
+  sleep_ticks_ = 0;
+  state_ = ProcessState::READY;
 }
 
 void Process::set_page_table_size(int size) { page_table_.resize(size); }
@@ -127,93 +181,141 @@ void Process::set_access_violation(bool violation) {
   access_violation_ = violation;
 }
 
-void Process::add_log(int cpu_core_id, const std::string &message) {
-  logs_.push_back(ProcessLog{.core_id = cpu_core_id, .message = message});
+void Process::add_resident_pages(int delta) {
+  resident_pages_.fetch_add(delta, std::memory_order_relaxed);
 }
 
-uint16_t Process::get_variable(const std::string &var_name,
-                               MemoryManager *memory_manager) {
-  if (symbol_table_.find(var_name) == symbol_table_.end()) {
-    symbol_table_[var_name] = next_symbol_address_;
-    next_symbol_address_ += sizeof(uint16_t); // assuming 2 bytes per variable
+void Process::clear_resident_pages() {
+  resident_pages_.store(0, std::memory_order_relaxed);
+}
+
+bool Process::pin_page_table() {
+  if (page_table_state_.fetch_add(1) & EVICTING) {
+    page_table_state_.fetch_sub(1, std::memory_order_release);
+    return false;
   }
 
-  uint32_t address = symbol_table_.at(var_name);
-  uint16_t value = 0;
+  return true;
+}
 
-  MemoryAccessResult result = memory_manager->read(address, this, value);
+void Process::unpin_page_table() {
+  page_table_state_.fetch_sub(1, std::memory_order_release);
+}
 
-  switch (result) {
-  case MemoryAccessResult::SUCCESS:
-    logs_.push_back(ProcessLog{.core_id = -1,
-                               .message = "Read variable " + var_name +
-                                          " with value " +
-                                          std::to_string(value)});
-    break;
-  case MemoryAccessResult::ACCESS_VIOLATION:
-    set_access_violation(true);
-    logs_.push_back(
-        ProcessLog{.core_id = -1,
-                   .message = "Access violation reading variable " + var_name});
-    break;
-  case MemoryAccessResult::ERROR:
-    logs_.push_back(ProcessLog{.core_id = -1,
-                               .message = "Error reading variable " + var_name +
-                                          " at address " +
-                                          std::to_string(address)});
-    break;
-  default:
-    break;
-  }
+// a pin only covers a single memory access, yields in case the pinning core
+// was preempted
+void Process::lock_page_table() {
+  page_table_state_.fetch_or(EVICTING);
 
-  return value;
+  while (page_table_state_.load(std::memory_order_acquire) != EVICTING)
+    std::this_thread::yield();
+}
+
+void Process::unlock_page_table() {
+  page_table_state_.fetch_and(~EVICTING, std::memory_order_release);
 }
 
-void Process::add_variable(std::pair<std::string, uint16_t> var,
-                           MemoryManager *memory_manager) {
-  std::string var_name = var.first;
-  uint16_t value = var.second;
+void Process::add_log(ProcessLog log) {
+  log.time = Clock::now();
+
+  std::lock_guard<std::mutex> lock(logs_mutex_);
+
+  if (logs_.size() < logs_capacity_) {
+    logs_.push_back(log);
+  } else {
+    size_t slot = log_count_ % logs_capacity_;
+
+    // the oldest batch is about to be overwritten, keep it on disk
+    if (log_segment_ && slot % LogSegment::BATCH_SIZE == 0)
+      spill_logs(slot);
 
-  if (symbol_table_.find(var_name) == symbol_table_.end()) {
-    symbol_table_[var_name] = next_symbol_address_;
-    next_symbol_address_ += sizeof(uint16_t); // assuming 2 bytes per variable
+    logs_[slot] = log;
   }
 
-  uint32_t address = symbol_table_.at(var_name);
+  log_count_++;
+}
+
+// the batch at first_slot holds the oldest logs still in the ring
+void Process::spill_logs(size_t first_slot) {
+  last_spilled_batch_ = log_segment_->append(
+      last_spilled_batch_, log_count_ - logs_capacity_, &logs_[first_slot],
+      LogSegment::BATCH_SIZE);
+}
+
+uint16_t Process::get_variable(uint16_t symbol, MemoryManager *memory_manager,
+                               MemoryAccessResult &out_result) {
+  uint32_t address = get_program().get_symbols()[symbol].address;
+  uint16_t value = 0;
+
+  out_result = memory_manager->read(address, this, value);
+
+  if (out_result == MemoryAccessResult::ACCESS_VIOLATION)
+    set_access_violation(true);
+
+  add_log(ProcessLog{.address = address,
+                     .a = symbol,
+                     .value = value,
+                     .event = LogEvent::READ_VARIABLE,
+                     .result = out_result});
+
+  return value;
+}
+
+MemoryAccessResult Process::add_variable(uint16_t symbol, uint16_t value,
+                                         MemoryManager *memory_manager) {
+  uint32_t address = get_program().get_symbols()[symbol].address;
 
   MemoryAccessResult result = memory_manager->write(address, this, value);
 
-  switch (result) {
-  case MemoryAccessResult::SUCCESS:
-    logs_.push_back(ProcessLog{.core_id = -1,
-                               .message = "Wrote variable " + var_name +
-                                          " with value " +
-                                          std::to_string(value)});
-    break;
-  case MemoryAccessResult::ACCESS_VIOLATION:
+  if (result == MemoryAccessResult::ACCESS_VIOLATION)
     set_access_violation(true);
-    logs_.push_back(
-        ProcessLog{.core_id = -1,
-                   .message = "Access violation writing variable " + var_name});
-    break;
-  case MemoryAccessResult::ERROR:
-    logs_.push_back(ProcessLog{.core_id = -1,
-                               .message = "Error writing variable " +
-                                          var.first + " at address " +
-                                          std::to_string(address)});
-    break;
-  default:
-    break;
-  }
+
+  add_log(ProcessLog{.address = address,
+                     .a = symbol,
+                     .value = value,
+                     .event = LogEvent::WRITE_VARIABLE,
+                     .result = result});
+
+  return result;
+}
+
+// a read of a variable the caller just read or wrote successfully, logs it
+// the same way get_variable would without going back to memory
+void Process::reuse_variable(uint16_t symbol, uint16_t value) {
+  add_log(ProcessLog{.address = get_program().get_symbols()[symbol].address,
+                     .a = symbol,
+                     .value = value,
+                     .event = LogEvent::READ_VARIABLE,
+                     .result = MemoryAccessResult::SUCCESS});
 }
 
-void Process::add_instructions(
-    std::vector<std::unique_ptr<IInstruction>> &&new_instructions) {
-  auto insert_pos = instructions_.begin() + instruction_pointer_ + 1;
+void Process::enter_loop(uint32_t body_length, uint32_t repeats) {
+  if (body_length == 0 || repeats == 0)
+    return;
+
+  loop_stack_[loop_depth_++] =
+      LoopFrame{.body_start = program_counter_ + 1,
+                .body_end = program_counter_ + 1 + body_length,
+                .repeats_left = repeats};
+}
+
+// true when there is an instruction at the program counter, decoding the
+// next one first when a streamed program has run out
+bool Process::fetch() {
+  if (program_counter_ < get_program().size())
+    return true;
+
+  if (stream_) {
+    std::lock_guard<std::mutex> lock(logs_mutex_);
+
+    if (!stream_->advance())
+      return false;
+
+    program_counter_ = 0;
+    return true;
+  }
 
-  instructions_.insert(insert_pos,
-                       std::make_move_iterator(new_instructions.begin()),
-                       std::make_move_iterator(new_instructions.end()));
+  return false;
 }
 
 void Process::sleep(int ticks) {
@@ -227,28 +329,13 @@ uint16_t Process::read_from_address(uint32_t address,
 
   MemoryAccessResult result = memory_manager->read(address, this, value);
 
-  switch (result) {
-  case MemoryAccessResult::SUCCESS:
-    logs_.push_back(ProcessLog{.core_id = -1,
-                               .message = "Read from address " +
-                                          std::to_string(address) + " value " +
-                                          std::to_string(value)});
-    break;
-  case MemoryAccessResult::ACCESS_VIOLATION:
+  if (result == MemoryAccessResult::ACCESS_VIOLATION)
     set_access_violation(true);
-    logs_.push_back(
-        ProcessLog{.core_id = -1,
-                   .message = "Access violation reading from address " +
-                              std::to_string(address)});
-    break;
-  case MemoryAccessResult::ERROR:
-    logs_.push_back(ProcessLog{.core_id = -1,
-                               .message = "Error reading from address " +
-                                          std::to_string(address)});
-    break;
-  default:
-    break;
-  }
+
+  add_log(ProcessLog{.address = address,
+                     .value = value,
+                     .event = LogEvent::READ_ADDRESS,
+                     .result = result});
 
   return value;
 }
@@ -257,26 +344,125 @@ void Process::write_to_address(uint32_t address, uint16_t value,
                                MemoryManager *memory_manager) {
   MemoryAccessResult result = memory_manager->write(address, this, value);
 
-  switch (result) {
-  case MemoryAccessResult::SUCCESS:
-    logs_.push_back(ProcessLog{.core_id = -1,
-                               .message = "Wrote to address " +
-                                          std::to_string(address) + " value " +
-                                          std::to_string(value)});
-    break;
-  case MemoryAccessResult::ACCESS_VIOLATION:
+  if (result == MemoryAccessResult::ACCESS_VIOLATION)
     set_access_violation(true);
-    logs_.push_back(
-        ProcessLog{.core_id = -1,
-                   .message = "Access violation writing to address " +
-                              std::to_string(address)});
-    break;
-  case MemoryAccessResult::ERROR:
-    logs_.push_back(ProcessLog{.core_id = -1,
-                               .message = "Error writing to address " +
-                                          std::to_string(address)});
-    break;
-  default:
-    break;
+
+  add_log(ProcessLog{.address = address,
+                     .value = value,
+                     .event = LogEvent::WRITE_ADDRESS,
+                     .result = result});
+}
+
+std::string Process::format_log_message(const ProcessLog &log) const {
+  const Program &program = get_program();
+  std::string address = std::to_string(log.address);
+  std::string value = std::to_string(log.value);
+
+  switch (log.event) {
+  case LogEvent::PRINT:
+    return program.get_text(log.a);
+  case LogEvent::PRINT_VAR:
+    return program.get_text(log.a) + value + program.get_text(log.b);
+  case LogEvent::FOR:
+    return "Entering For loop with " + std::to_string(log.a) +
+           " repeats at depth " + std::to_string(log.b);
+  case LogEvent::READ_VARIABLE:
+  case LogEvent::WRITE_VARIABLE: {
+    bool is_read = log.event == LogEvent::READ_VARIABLE;
+    const std::string &name = program.get_symbols()[log.a].name;
+
+    if (log.result == MemoryAccessResult::ACCESS_VIOLATION)
+      return std::string("Access violation ") +
+             (is_read ? "reading" : "writing") + " variable " + name;
+
+    if (log.result == MemoryAccessResult::ERROR)
+      return std::string("Error ") + (is_read ? "reading" : "writing") +
+             " variable " + name + " at address " + address;
+
+    return (is_read ? "Read variable " : "Wrote variable ") + name +
+           " with value " + value;
   }
+  case LogEvent::READ_ADDRESS:
+  case LogEvent::WRITE_ADDRESS: {
+    bool is_read = log.event == LogEvent::READ_ADDRESS;
+
+    if (log.result == MemoryAccessResult::ACCESS_VIOLATION)
+      return std::string("Access violation ") +
+             (is_read ? "reading from" : "writing to") + " address " + address;
+
+    if (log.result == MemoryAccessResult::ERROR)
+      return std::string("Error ") +
+             (is_read ? "reading from" : "writing to") + " address " + address;
+
+    return std::string(is_read ? "Read from" : "Wrote to") + " address " +
+           address + " value " + value;
+  }
+  }
+
+  return "";
+}
+
+uint64_t Process::get_first_log() const {
+  std::lock_guard<std::mutex> lock(logs_mutex_);
+  return log_segment_ ? 0 : log_count_ - logs_.size();
+}
+
+uint64_t Process::get_log_count() const {
+  std::lock_guard<std::mutex> lock(logs_mutex_);
+  return log_count_;
+}
+
+// spilled logs first, then the ring, ranges outside what is kept are
+// clamped
+std::vector<ProcessLog> Process::get_logs(uint64_t first_log,
+                                          uint64_t last_log) const {
+  std::vector<ProcessLog> logs;
+  int64_t spilled_batch;
+  uint64_t spilled_last_log;
+
+  {
+    std::lock_guard<std::mutex> lock(logs_mutex_);
+    uint64_t memory_start = log_count_ - logs_.size();
+
+    first_log = std::max(first_log, log_segment_ ? 0 : memory_start);
+    last_log = std::min(last_log, log_count_);
+
+    if (first_log >= last_log)
+      return logs;
+
+    for (uint64_t i = std::max(first_log, memory_start); i < last_log; ++i)
+      logs.push_back(logs_[i % logs_capacity_]);
+
+    spilled_batch = last_spilled_batch_;
+    spilled_last_log = std::min(last_log, memory_start);
+  }
+
+  // spilled batches never change, read them without holding up the running
+  // core while the writer drains
+  if (first_log < spilled_last_log) {
+    std::vector<ProcessLog> spilled =
+        log_segment_->read(spilled_batch, first_log, spilled_last_log);
+
+    logs.insert(logs.begin(), spilled.begin(), spilled.end());
+  }
+
+  return logs;
+}
+
+// (timestamp) Core:N "message", memory accesses have no core
+std::string Process::format_logs(uint64_t first_log, uint64_t last_log) const {
+  std::vector<ProcessLog> logs = get_logs(first_log, last_log);
+  std::lock_guard<std::mutex> lock(logs_mutex_);
+  std::string output;
+
+  for (const ProcessLog &log : logs) {
+    output += "(" + Clock::format(log.time) + ") ";
+
+    if (log.core_id >= 0)
+      output += "Core:" + std::to_string(log.core_id) + " ";
+
+    output += "\"" + format_log_message(log) + "\"\n";
+  }
+
+  return output;
 }
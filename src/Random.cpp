@@ -0,0 +1,64 @@
+#include "Random.hpp"
+
+namespace {
+
+// splitmix64 finalizer
+uint64_t mix(uint64_t value) {
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  return value;
+}
+
+constexpr uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+
+} // namespace
+
+uint64_t Random::seed_ = 0;
+
+RandomStream::RandomStream(uint64_t key) : key_(key) {}
+
+uint64_t RandomStream::next() {
+  return mix(key_ + (++counter_) * GOLDEN_GAMMA);
+}
+
+// [0, bound), multiply-shift instead of modulo to avoid the division
+uint32_t RandomStream::next_below(uint32_t bound) {
+  if (bound == 0)
+    return 0;
+
+  return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+}
+
+// [min, max]
+uint32_t RandomStream::next_in_range(uint32_t min, uint32_t max) {
+  if (max <= min)
+    return min;
+
+  uint64_t span = static_cast<uint64_t>(max) - min + 1;
+
+  return min + static_cast<uint32_t>(((next() >> 32) * span) >> 32);
+}
+
+void Random::set_seed(uint64_t seed) { seed_ = seed; }
+
+uint64_t Random::get_seed() { return seed_; }
+
+RandomStream Random::stream(Domain domain, uint64_t stream_id) {
+  return RandomStream(mix(
+      seed_ ^ mix(static_cast<uint64_t>(domain) * GOLDEN_GAMMA + stream_id)));
+}
+
+RandomStream Random::stream(Domain domain, const std::string &name) {
+  // fnv-1a, stable across runs and platforms unlike std::hash
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (unsigned char c : name) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+
+  return stream(domain, hash);
+}
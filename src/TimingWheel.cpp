@@ -0,0 +1,83 @@
+#include "TimingWheel.hpp"
+#include <algorithm>
+
+void TimingWheel::schedule(Process *process, uint64_t delay) {
+  insert(Timer{current_tick_ + delay, process});
+  size_++;
+}
+
+// expires every timer due on the current tick, then moves to the next tick
+const std::vector<Process *> &TimingWheel::advance() {
+  expired_.clear();
+
+  // entering a new far slot, pull its timers into the near slots
+  if ((current_tick_ & SLOT_MASK) == 0)
+    cascade();
+
+  std::vector<Timer> &slot = near_slots_[current_tick_ & SLOT_MASK];
+
+  for (const Timer &timer : slot)
+    expired_.push_back(timer.process);
+
+  size_ -= slot.size();
+  slot.clear();
+  current_tick_++;
+
+  return expired_;
+}
+
+// turns the wheel without expiring anything, callers must not skip past
+// ticks_until_next_expiry()
+void TimingWheel::skip(uint64_t ticks) {
+  for (uint64_t i = 0; i < ticks; ++i) {
+    if ((current_tick_ & SLOT_MASK) == 0)
+      cascade();
+
+    current_tick_++;
+  }
+}
+
+// 0 means the next advance() expires at least one timer
+uint64_t TimingWheel::ticks_until_next_expiry() const {
+  uint64_t next_expiry = UINT64_MAX;
+
+  for (uint64_t i = 0; i < NUM_SLOTS; ++i) {
+    if (!near_slots_[(current_tick_ + i) & SLOT_MASK].empty()) {
+      next_expiry = i;
+      break;
+    }
+  }
+
+  for (const auto &slot : far_slots_) {
+    for (const Timer &timer : slot)
+      next_expiry = std::min(next_expiry, timer.expires_at - current_tick_);
+  }
+
+  return next_expiry;
+}
+
+bool TimingWheel::empty() const { return size_ == 0; }
+
+void TimingWheel::insert(const Timer &timer) {
+  if (timer.expires_at - current_tick_ < NUM_SLOTS) {
+    near_slots_[timer.expires_at & SLOT_MASK].push_back(timer);
+    return;
+  }
+
+  far_slots_[(timer.expires_at >> SLOT_BITS) & SLOT_MASK].push_back(timer);
+}
+
+void TimingWheel::cascade() {
+  std::vector<Timer> &slot =
+      far_slots_[(current_tick_ >> SLOT_BITS) & SLOT_MASK];
+
+  if (slot.empty())
+    return;
+
+  // timers more than a full turn away go back into the same far slot
+  std::vector<Timer> timers;
+  timers.swap(slot);
+
+  for (const Timer &timer : timers)
+    insert(timer);
+}
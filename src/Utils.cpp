@@ -1,12 +1,35 @@
 #include "Utils.hpp"
-#include <chrono>
+#include <cstdio>
+#include <sys/resource.h>
 
-std::string Utils::current_timestamp() {
-  auto now = std::chrono::system_clock::now();
-  std::time_t now_time = std::chrono::system_clock::to_time_t(now);
-  std::tm *ltm = std::localtime(&now_time);
+uint64_t Utils::peak_rss_kb() {
+  struct rusage usage {};
 
-  char buffer[30];
-  std::strftime(buffer, sizeof(buffer), "%m/%d/%Y %I:%M:%S%p", ltm);
-  return std::string(buffer);
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+#ifdef __APPLE__
+  return static_cast<uint64_t>(usage.ru_maxrss) / 1024; // bytes on macos
+#else
+  return static_cast<uint64_t>(usage.ru_maxrss); // kilobytes on linux
+#endif
+}
+
+std::string Utils::json_escape(const std::string &text) {
+  std::string escaped;
+
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char code[7];
+      std::snprintf(code, sizeof(code), "\\u%04x", c);
+      escaped += code;
+    } else {
+      escaped += c;
+    }
+  }
+
+  return escaped;
 }
@@ -1,40 +1,32 @@
 #include "instructions/Arithmetic.hpp"
-#include <algorithm>
-#include <limits>
+#include "instructions/Program.hpp"
 
 Arithmetic::Arithmetic(const std::string &var1, const Operand &var2,
                        const Operand &var3, const Operator &op)
     : var1_(var1), var2_(var2), var3_(var3), operator_(op) {}
 
-void Arithmetic::execute(InstructionContext context) {
-  uint16_t a = std::holds_alternative<std::string>(var2_)
-                   ? context.get_variable(std::get<std::string>(var2_))
-                   : std::get<uint16_t>(var2_);
+void Arithmetic::compile(ProgramBuilder &builder) const {
+  Bytecode bytecode{.opcode = operator_ == Operator::ADD ? Opcode::ADD
+                                                         : Opcode::SUBTRACT};
 
-  uint16_t b = std::holds_alternative<std::string>(var3_)
-                   ? context.get_variable(std::get<std::string>(var3_))
-                   : std::get<uint16_t>(var3_);
+  // operands are read before the destination is written
+  if (std::holds_alternative<std::string>(var2_)) {
+    bytecode.flags |= Bytecode::LHS_VARIABLE;
+    bytecode.b = builder.resolve_symbol(std::get<std::string>(var2_));
+  } else {
+    bytecode.b = std::get<uint16_t>(var2_);
+  }
 
-  uint16_t result = 0;
-  switch (operator_) {
-    case Operator::ADD: {
-      int a_val = static_cast<int>(a);
-      int b_val = static_cast<int>(b);
-      result = std::clamp<int>(a_val + b_val, 0,
-                               std::numeric_limits<uint16_t>::max());
-      break;
-    }
-    case Operator::SUBTRACT: {
-      int a_val = static_cast<int>(a);
-      int b_val = static_cast<int>(b);
-      result = std::clamp<int>(a_val - b_val, 0,
-                               std::numeric_limits<uint16_t>::max());
-      break;
-    }
+  if (std::holds_alternative<std::string>(var3_)) {
+    bytecode.flags |= Bytecode::RHS_VARIABLE;
+    bytecode.c = builder.resolve_symbol(std::get<std::string>(var3_));
+  } else {
+    bytecode.c = std::get<uint16_t>(var3_);
   }
 
-  context.add_variable({var1_, result});
-  // context.add_log("Arithmetic: " + var1_ + " = " + std::to_string(result));
+  bytecode.a = builder.resolve_symbol(var1_);
+
+  builder.emit(bytecode);
 }
 
 std::unique_ptr<IInstruction> Arithmetic::clone() {
@@ -1,10 +1,12 @@
 #include "instructions/Declare.hpp"
+#include "instructions/Program.hpp"
 
 Declare::Declare(const Variable &variable) : variable_(variable) {}
 
-void Declare::execute(InstructionContext context) {
-  context.add_variable(variable_);
-  // context.add_log("Declare variable " + variable_.first + " with value " + std::to_string(variable_.second));
+void Declare::compile(ProgramBuilder &builder) const {
+  builder.emit(Bytecode{.opcode = Opcode::DECLARE,
+                        .a = builder.resolve_symbol(variable_.first),
+                        .b = variable_.second});
 }
 
 std::unique_ptr<IInstruction> Declare::clone() {
@@ -1,46 +1,28 @@
 #include "instructions/For.hpp"
-#include <algorithm>
-#include <cctype>
+#include "instructions/Program.hpp"
 
 For::For(std::vector<std::unique_ptr<IInstruction>> instructions, int repeats)
     : instructions_(std::move(instructions)), repeats_(repeats) {}
 
-void For::execute(InstructionContext context) {
-  static thread_local int depth = 0;
+// the body is compiled once after the FOR marker and repeated at runtime by
+// the process loop stack, bodies nested past MAX_LOOP_DEPTH are dropped
+void For::compile(ProgramBuilder &builder) const {
+  builder.enter_loop();
 
-  if (depth >= 3) {
-    return;
-  }
-
-  ++depth;
-
-  context.add_log("Entering For loop with " + std::to_string(repeats_) +
-                  " repeats at depth " + std::to_string(depth));
-
-  for (int i = 0; i < repeats_; ++i) {
-    std::vector<std::unique_ptr<IInstruction>> cloned_instructions;
-
-    // context.add_log("For loop iteration " + std::to_string(i + 1));
+  size_t for_index = builder.size();
+  builder.emit(Bytecode{.opcode = Opcode::FOR,
+                        .a = static_cast<uint16_t>(repeats_),
+                        .b = static_cast<uint16_t>(builder.get_loop_depth())});
 
+  if (builder.get_loop_depth() <= MAX_LOOP_DEPTH) {
     for (const auto &instr : instructions_) {
-      cloned_instructions.push_back(instr->clone());
-
-      // suppress warning hack
-      const IInstruction &instr_ref = *instr;
-      std::string instruction_type = typeid(instr_ref).name();
-
-      instruction_type.erase(
-          std::remove_if(instruction_type.begin(), instruction_type.end(),
-                         [](unsigned char c) { return std::isdigit(c); }),
-          instruction_type.end());
-
-      // context.add_log("Instruction Type: " + instruction_type);
+      instr->compile(builder);
     }
-
-    context.add_instructions(std::move(cloned_instructions));
   }
 
-  --depth;
+  builder.at(for_index).address = builder.size() - for_index - 1;
+
+  builder.exit_loop();
 }
 
 std::unique_ptr<IInstruction> For::clone() {
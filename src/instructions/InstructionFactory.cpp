@@ -2,12 +2,13 @@
 #include <iostream>
 #include <limits>
 #include <sstream>
+#include <unordered_map>
 
 std::vector<std::unique_ptr<IInstruction>>
 InstructionFactory::create_instructions(const std::string &process_name,
                                         int num_instructions, int max_ins,
-                                        int min_ins, int start_depth,
-                                        int max_depth) {
+                                        int min_ins, RandomStream &rng,
+                                        int start_depth, int max_depth) {
   if (start_depth >= max_depth) {
     return {};
   }
@@ -16,86 +17,89 @@ InstructionFactory::create_instructions(const std::string &process_name,
   int curr_instructions_count = 0;
 
   while (curr_instructions_count < num_instructions) {
-    int instruction_type =
-        rand() %
-        (static_cast<int>(InstructionFactory::InstructionType::FOR) + 1);
+    std::unique_ptr<IInstruction> instruction = create_next_instruction(
+        process_name, num_instructions, max_ins, min_ins, rng, start_depth,
+        max_depth, curr_instructions_count);
 
-    switch (
-        static_cast<InstructionFactory::InstructionType>(instruction_type)) {
-    case InstructionFactory::InstructionType::PRINT:
-      instructions.push_back(InstructionFactory::create_print(
-          "Hello from process " + process_name));
-
-      ++curr_instructions_count;
-      break;
-    case InstructionFactory::InstructionType::DECLARE: {
-      std::string var_name = "var" + std::to_string(rand() % num_instructions);
-      uint16_t val = rand() % (std::numeric_limits<uint16_t>::max() + 1);
-
-      instructions.push_back(InstructionFactory::create_declare(var_name, val));
-
-      ++curr_instructions_count;
-      break;
-    }
-    case InstructionFactory::InstructionType::ADD:
-      instructions.push_back(InstructionFactory::create_arithmetic(
-          "add_var", InstructionFactory::random_operand(),
-          InstructionFactory::random_operand(), Arithmetic::Operator::ADD));
-
-      ++curr_instructions_count;
-      break;
-    case InstructionFactory::InstructionType::SUBTRACT:
-      instructions.push_back(InstructionFactory::create_arithmetic(
-          "sub_var", InstructionFactory::random_operand(),
-          InstructionFactory::random_operand(),
-          Arithmetic::Operator::SUBTRACT));
-
-      ++curr_instructions_count;
-      break;
-    case InstructionFactory::InstructionType::SLEEP: {
-      uint8_t ticks = 1 + rand() % 2; // sleep between 1 and 2 ticks
-
-      instructions.push_back(InstructionFactory::create_sleep(ticks));
+    if (instruction)
+      instructions.push_back(std::move(instruction));
+  }
 
-      ++curr_instructions_count;
-      break;
-    }
-    case InstructionFactory::InstructionType::FOR: {
-      // can't have loop without 2 or more instructions
-      if (curr_instructions_count >= num_instructions - 1)
-        continue;
+  return instructions;
+}
 
-      ++curr_instructions_count; // loop itself counts as an instruction
+// one step of create_instructions, returns nullptr when the draw produced
+// nothing, curr_instructions_count counts loop bodies once per repeat
+std::unique_ptr<IInstruction> InstructionFactory::create_next_instruction(
+    const std::string &process_name, int num_instructions, int max_ins,
+    int min_ins, RandomStream &rng, int start_depth, int max_depth,
+    int &curr_instructions_count) {
+  int instruction_type = rng.next_below(
+      static_cast<int>(InstructionFactory::InstructionType::FOR) + 1);
+
+  switch (static_cast<InstructionFactory::InstructionType>(instruction_type)) {
+  case InstructionFactory::InstructionType::PRINT:
+    ++curr_instructions_count;
+    return InstructionFactory::create_print("Hello from process " +
+                                            process_name);
+  case InstructionFactory::InstructionType::DECLARE: {
+    std::string var_name =
+        "var" + std::to_string(rng.next_below(num_instructions));
+    uint16_t val = rng.next_below(std::numeric_limits<uint16_t>::max() + 1);
+
+    ++curr_instructions_count;
+    return InstructionFactory::create_declare(var_name, val);
+  }
+  case InstructionFactory::InstructionType::ADD:
+    ++curr_instructions_count;
+    return InstructionFactory::create_arithmetic(
+        "add_var", InstructionFactory::random_operand(rng),
+        InstructionFactory::random_operand(rng), Arithmetic::Operator::ADD);
+  case InstructionFactory::InstructionType::SUBTRACT:
+    ++curr_instructions_count;
+    return InstructionFactory::create_arithmetic(
+        "sub_var", InstructionFactory::random_operand(rng),
+        InstructionFactory::random_operand(rng),
+        Arithmetic::Operator::SUBTRACT);
+  case InstructionFactory::InstructionType::SLEEP: {
+    uint8_t ticks = rng.next_in_range(1, 2); // sleep between 1 and 2 ticks
+
+    ++curr_instructions_count;
+    return InstructionFactory::create_sleep(ticks);
+  }
+  case InstructionFactory::InstructionType::FOR: {
+    // can't have loop without 2 or more instructions
+    if (curr_instructions_count >= num_instructions - 1)
+      return nullptr;
 
-      int remaining = num_instructions - curr_instructions_count;
+    ++curr_instructions_count; // loop itself counts as an instruction
 
-      // 1 to 5 instructions
-      int loop_instructions_count = std::min(remaining, 1 + rand() % 5);
+    int remaining = num_instructions - curr_instructions_count;
 
-      int remaining_repeats = remaining / loop_instructions_count;
+    // 1 to 5 instructions
+    int loop_instructions_count =
+        std::min(remaining, static_cast<int>(rng.next_in_range(1, 5)));
 
-      // 1 to 5 repeats
-      int repeats = std::min(remaining_repeats, 1 + rand() % 5);
+    int remaining_repeats = remaining / loop_instructions_count;
 
-      instructions.push_back(InstructionFactory::create_for(
-          process_name, loop_instructions_count, min_ins, max_ins, repeats,
-          start_depth, max_depth));
+    // 1 to 5 repeats
+    int repeats =
+        std::min(remaining_repeats, static_cast<int>(rng.next_in_range(1, 5)));
 
-      curr_instructions_count += loop_instructions_count * repeats;
+    curr_instructions_count += loop_instructions_count * repeats;
 
-      break;
-    }
-    default:
-      break;
-    }
+    return InstructionFactory::create_for(process_name, loop_instructions_count,
+                                          min_ins, max_ins, repeats, rng,
+                                          start_depth, max_depth);
+  }
+  default:
+    return nullptr;
   }
-
-  return instructions;
 }
 
 std::vector<std::unique_ptr<IInstruction>>
 InstructionFactory::create_mo1_demo_instructions(
-    const std::string &process_name, int num_instructions) {
+    const std::string &process_name, int num_instructions, RandomStream &rng) {
   std::vector<std::unique_ptr<IInstruction>> instructions;
   int curr_instructions_count = 0;
 
@@ -107,7 +111,7 @@ InstructionFactory::create_mo1_demo_instructions(
       break;
     }
     case 1: {
-      uint16_t val = 1 + rand() % 10; // number between 1 and 10
+      uint16_t val = rng.next_in_range(1, 10); // number between 1 and 10
       instructions.push_back(InstructionFactory::create_arithmetic(
           "x", Arithmetic::Operand("x"), Arithmetic::Operand(val),
           Arithmetic::Operator::ADD));
@@ -297,11 +301,12 @@ std::unique_ptr<Sleep> InstructionFactory::create_sleep(uint8_t ticks) {
 std::unique_ptr<For>
 InstructionFactory::create_for(const std::string &process_name,
                                int num_instructions, int min_ins, int max_ins,
-                               int repeats, int start_depth, int max_depth) {
+                               int repeats, RandomStream &rng, int start_depth,
+                               int max_depth) {
 
   return std::make_unique<For>(
       create_instructions(process_name, num_instructions, max_ins, min_ins,
-                          start_depth + 1, max_depth),
+                          rng, start_depth + 1, max_depth),
       repeats);
 }
 
@@ -316,14 +321,14 @@ std::unique_ptr<Write> InstructionFactory::create_write(uint32_t address,
 }
 
 // helpers
-Arithmetic::Operand InstructionFactory::random_operand() {
-  int choice = rand() % 2;
+Arithmetic::Operand InstructionFactory::random_operand(RandomStream &rng) {
+  int choice = rng.next_below(2);
 
   switch (choice) {
   case 0: // variable
-    return Arithmetic::Operand("var" + std::to_string(rand() % 100));
+    return Arithmetic::Operand("var" + std::to_string(rng.next_below(100)));
   case 1: // constant
-    return Arithmetic::Operand(uint16_t(rand() % 100));
+    return Arithmetic::Operand(uint16_t(rng.next_below(100)));
   default:
     return Arithmetic::Operand(uint16_t(0));
   }
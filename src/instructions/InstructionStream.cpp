@@ -0,0 +1,26 @@
+#include "instructions/InstructionStream.hpp"
+#include "instructions/InstructionFactory.hpp"
+
+InstructionStream::InstructionStream(const std::string &process_name,
+                                     int num_instructions, int max_ins,
+                                     int min_ins, const RandomStream &rng)
+    : process_name_(process_name), num_instructions_(num_instructions),
+      max_ins_(max_ins), min_ins_(min_ins), rng_(rng) {}
+
+bool InstructionStream::advance() {
+  builder_.clear_code();
+
+  while (generated_count_ < num_instructions_) {
+    std::unique_ptr<IInstruction> instruction =
+        InstructionFactory::create_next_instruction(
+            process_name_, num_instructions_, max_ins_, min_ins_, rng_, 0,
+            MAX_LOOP_DEPTH, generated_count_);
+
+    if (instruction) {
+      instruction->compile(builder_);
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -1,4 +1,5 @@
 #include "instructions/Print.hpp"
+#include "instructions/Program.hpp"
 
 Print::Print(const std::string &msg) : message_(msg) {
   size_t first_quote = msg.find('\"');
@@ -19,12 +20,15 @@ Print::Print(const std::string &msg) : message_(msg) {
   suffix_ = "";
 }
 
-void Print::execute(InstructionContext context) {
+void Print::compile(ProgramBuilder &builder) const {
   if (!var_name_.empty()) {
-    uint16_t value = context.get_variable(var_name_);
-    context.add_log(prefix_ + std::to_string(value) + suffix_);
+    builder.emit(Bytecode{.opcode = Opcode::PRINT_VAR,
+                          .a = builder.intern_text(prefix_),
+                          .b = builder.resolve_symbol(var_name_),
+                          .c = builder.intern_text(suffix_)});
   } else {
-    context.add_log(prefix_);
+    builder.emit(
+        Bytecode{.opcode = Opcode::PRINT, .a = builder.intern_text(prefix_)});
   }
 }
 
@@ -0,0 +1,214 @@
+#include "instructions/Program.hpp"
+#include "instructions/ExecutionContext.hpp"
+#include "MemoryManager.hpp"
+#include <algorithm>
+#include <limits>
+
+Program Program::compile(
+    const std::vector<std::unique_ptr<IInstruction>> &instructions) {
+  ProgramBuilder builder;
+
+  for (const auto &instruction : instructions) {
+    instruction->compile(builder);
+  }
+
+  return builder.build();
+}
+
+void Program::execute(size_t program_counter, ExecutionContext &context,
+                      int width) const {
+  if (width == MAX_FUSED_WIDTH) {
+    execute_fused(code_[program_counter], code_[program_counter + 1],
+                  context);
+    return;
+  }
+
+  execute_one(code_[program_counter], context);
+}
+
+int Program::get_width(size_t program_counter, int max_width) const {
+  if (max_width >= MAX_FUSED_WIDTH && program_counter < code_.size() &&
+      (code_[program_counter].flags & Bytecode::FUSED_WITH_NEXT))
+    return MAX_FUSED_WIDTH;
+
+  return 1;
+}
+
+void Program::execute_one(const Bytecode &bytecode,
+                          ExecutionContext &context) const {
+  switch (bytecode.opcode) {
+  case Opcode::PRINT:
+    context.add_log(LogEvent::PRINT, bytecode.a);
+    break;
+  case Opcode::PRINT_VAR: {
+    uint16_t value = context.get_variable(bytecode.b);
+    context.add_log(LogEvent::PRINT_VAR, bytecode.a, bytecode.c, value);
+    break;
+  }
+  case Opcode::DECLARE:
+    context.add_variable(bytecode.a, bytecode.b);
+    break;
+  case Opcode::ADD:
+  case Opcode::SUBTRACT: {
+    int lhs = (bytecode.flags & Bytecode::LHS_VARIABLE)
+                  ? context.get_variable(bytecode.b)
+                  : bytecode.b;
+    int rhs = (bytecode.flags & Bytecode::RHS_VARIABLE)
+                  ? context.get_variable(bytecode.c)
+                  : bytecode.c;
+
+    context.add_variable(bytecode.a, arithmetic(bytecode, lhs, rhs));
+    break;
+  }
+  case Opcode::SLEEP:
+    context.sleep(bytecode.a);
+    break;
+  case Opcode::FOR:
+    context.add_log(LogEvent::FOR, bytecode.a, bytecode.b);
+    context.enter_loop(bytecode.address, bytecode.a);
+    break;
+  case Opcode::READ: {
+    uint16_t value = context.read_from_address(bytecode.address);
+    context.add_variable(bytecode.a, value);
+    break;
+  }
+  case Opcode::WRITE:
+    context.write_to_address(bytecode.address, bytecode.a);
+    break;
+  }
+}
+
+// the second half reads the variable the first half just moved through
+// memory, a superinstruction reuses that value instead of reading it back
+// logs match running the halves one by one, a failed first access falls back
+// to a real read so its error shows up again
+void Program::execute_fused(const Bytecode &first, const Bytecode &second,
+                            ExecutionContext &context) const {
+  switch (first.opcode) {
+  case Opcode::READ: { // READ v addr, PRINT "v"
+    uint16_t value = context.read_from_address(first.address);
+
+    if (context.add_variable(first.a, value) == MemoryAccessResult::SUCCESS)
+      context.reuse_variable(second.b, value);
+    else
+      value = context.get_variable(second.b);
+
+    context.add_log(LogEvent::PRINT_VAR, second.a, second.c, value);
+    break;
+  }
+  case Opcode::PRINT_VAR: { // PRINT "x", ADD x x k
+    MemoryAccessResult result;
+    uint16_t value = context.get_variable(first.b, result);
+    context.add_log(LogEvent::PRINT_VAR, first.a, first.c, value);
+
+    auto operand = [&](uint8_t flag, uint16_t operand) -> int {
+      if (!(second.flags & flag))
+        return operand;
+
+      if (operand != first.b || result != MemoryAccessResult::SUCCESS)
+        return context.get_variable(operand);
+
+      context.reuse_variable(operand, value);
+      return value;
+    };
+
+    int lhs = operand(Bytecode::LHS_VARIABLE, second.b);
+    int rhs = operand(Bytecode::RHS_VARIABLE, second.c);
+
+    context.add_variable(second.a, arithmetic(second, lhs, rhs));
+    break;
+  }
+  default:
+    execute_one(first, context);
+    execute_one(second, context);
+    break;
+  }
+}
+
+uint16_t Program::arithmetic(const Bytecode &bytecode, int lhs, int rhs) {
+  int result = bytecode.opcode == Opcode::ADD ? lhs + rhs : lhs - rhs;
+
+  return std::clamp<int>(result, 0, std::numeric_limits<uint16_t>::max());
+}
+
+// marks instruction pairs that commonly follow each other, a pair never
+// spans the end of a loop body so loops still jump back between dispatches
+void Program::fuse_superinstructions() {
+  std::vector<size_t> body_ends;
+  size_t i = 0;
+
+  while (i + 1 < code_.size()) {
+    while (!body_ends.empty() && body_ends.back() <= i)
+      body_ends.pop_back();
+
+    Bytecode &first = code_[i];
+
+    if (first.opcode == Opcode::FOR) {
+      if (first.address > 0)
+        body_ends.push_back(i + 1 + first.address);
+      i++;
+      continue;
+    }
+
+    bool ends_body = !body_ends.empty() && body_ends.back() == i + 1;
+
+    if (!ends_body && is_fusable(first, code_[i + 1])) {
+      first.flags |= Bytecode::FUSED_WITH_NEXT;
+      i += 2;
+    } else {
+      i++;
+    }
+  }
+}
+
+bool Program::is_fusable(const Bytecode &first, const Bytecode &second) {
+  switch (first.opcode) {
+  case Opcode::READ: // READ v addr, PRINT "v"
+    return second.opcode == Opcode::PRINT_VAR && second.b == first.a;
+  case Opcode::PRINT_VAR: // PRINT "x", ADD x x k as in the mo1 demo
+    return (second.opcode == Opcode::ADD ||
+            second.opcode == Opcode::SUBTRACT) &&
+           (((second.flags & Bytecode::LHS_VARIABLE) && second.b == first.b) ||
+            ((second.flags & Bytecode::RHS_VARIABLE) && second.c == first.b));
+  default:
+    return false;
+  }
+}
+
+void ProgramBuilder::emit(const Bytecode &bytecode) {
+  program_.code_.push_back(bytecode);
+}
+
+uint16_t ProgramBuilder::resolve_symbol(const std::string &name) {
+  auto [it, inserted] = symbol_ids_.try_emplace(name, program_.symbols_.size());
+  if (!inserted)
+    return it->second;
+
+  // x is pinned at address 0, required for mo1 demo
+  if (name == "x") {
+    program_.symbols_.push_back(Symbol{.name = name, .address = 0});
+  } else {
+    program_.symbols_.push_back(
+        Symbol{.name = name, .address = next_symbol_address_});
+    next_symbol_address_ += sizeof(uint16_t); // assuming 2 bytes per variable
+  }
+
+  return it->second;
+}
+
+uint16_t ProgramBuilder::intern_text(const std::string &text) {
+  auto [it, inserted] = text_ids_.try_emplace(text, program_.texts_.size());
+  if (inserted)
+    program_.texts_.push_back(text);
+
+  return it->second;
+}
+
+Program ProgramBuilder::build() {
+  program_.fuse_superinstructions();
+  program_.code_.shrink_to_fit();
+  symbol_ids_.clear();
+  text_ids_.clear();
+
+  return std::move(program_);
+}
@@ -0,0 +1,43 @@
+#include "instructions/ProgramCache.hpp"
+#include <algorithm>
+
+std::shared_ptr<const Program>
+ProgramCache::get_or_build(const std::string &key,
+                           const std::function<Program()> &build) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto [it, inserted] = programs_.try_emplace(key);
+
+  if (std::shared_ptr<const Program> program = it->second.lock())
+    return program;
+
+  std::shared_ptr<const Program> program;
+
+  try {
+    program = std::make_shared<const Program>(build());
+  } catch (...) {
+    // bad source text, keep no entry for it
+    programs_.erase(it);
+    throw;
+  }
+
+  it->second = program;
+
+  if (inserted)
+    drop_expired();
+
+  return program;
+}
+
+// sweeps once the map doubles so every source text seen does not stay keyed
+// forever, amortized constant per new key
+void ProgramCache::drop_expired() {
+  if (programs_.size() < sweep_at_)
+    return;
+
+  std::erase_if(programs_, [](const auto &entry) {
+    return entry.second.expired();
+  });
+
+  sweep_at_ = std::max(MIN_SWEEP_SIZE, programs_.size() * 2);
+}
@@ -1,11 +1,13 @@
 #include "instructions/Read.hpp"
+#include "instructions/Program.hpp"
 
 Read::Read(const std::string &var_name, uint32_t memory_address)
     : var_name_(var_name), memory_address_(memory_address) {}
 
-void Read::execute(InstructionContext context) {
-  uint16_t value = context.read_from_address(memory_address_);
-  context.add_variable({var_name_, value});
+void Read::compile(ProgramBuilder &builder) const {
+  builder.emit(Bytecode{.opcode = Opcode::READ,
+                        .a = builder.resolve_symbol(var_name_),
+                        .address = memory_address_});
 }
 
 std::unique_ptr<IInstruction> Read::clone() {
@@ -1,10 +1,10 @@
 #include "instructions/Sleep.hpp"
+#include "instructions/Program.hpp"
 
 Sleep::Sleep(uint8_t ticks) : ticks_(ticks) {}
 
-void Sleep::execute(InstructionContext context) {
-  context.sleep(ticks_);
-  // context.add_log("Sleep for " + std::to_string(ticks_) + " ticks");
+void Sleep::compile(ProgramBuilder &builder) const {
+  builder.emit(Bytecode{.opcode = Opcode::SLEEP, .a = ticks_});
 }
 
 std::unique_ptr<IInstruction> Sleep::clone() {
@@ -1,10 +1,12 @@
 #include "instructions/Write.hpp"
+#include "instructions/Program.hpp"
 
 Write::Write(uint32_t memory_address, uint16_t value)
     : memory_address_(memory_address), value_(value) {}
 
-void Write::execute(InstructionContext context) {
-  context.write_to_address(memory_address_, value_);
+void Write::compile(ProgramBuilder &builder) const {
+  builder.emit(Bytecode{
+      .opcode = Opcode::WRITE, .a = value_, .address = memory_address_});
 }
 
 std::unique_ptr<IInstruction> Write::clone() {
@@ -1,11 +1,107 @@
 #include "Emulator.hpp"
+#include <cctype>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <string>
 
-int main() {
-  srand(time(NULL));
+// whole argument must be a non-negative number, no sign or trailing text
+static bool parse_count(const char *text, uint64_t &out_value) {
+  if (!std::isdigit(static_cast<unsigned char>(text[0])))
+    return false;
+
+  try {
+    size_t length = 0;
+    out_value = std::stoull(text, &length);
+    return text[length] == '\0';
+  } catch (const std::exception &) {
+    return false;
+  }
+}
+
+static bool parse_seconds(const char *text, double &out_value) {
+  if (!std::isdigit(static_cast<unsigned char>(text[0])) && text[0] != '.')
+    return false;
+
+  try {
+    size_t length = 0;
+    out_value = std::stod(text, &length);
+    return text[length] == '\0' && std::isfinite(out_value);
+  } catch (const std::exception &) {
+    return false;
+  }
+}
+
+static void print_usage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [--bench [--cycles N] [--seconds S] [--config FILE]"
+               " [--seed N] [--micro N]]"
+            << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  bool is_benchmark = false;
+  bool has_benchmark_options = false;
+  BenchmarkOptions benchmark_options;
+
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+
+    if (std::strcmp(argv[i], "--bench") == 0) {
+      is_benchmark = true;
+      continue;
+    }
+
+    has_benchmark_options = true;
+
+    bool is_valid = has_value;
+
+    if (std::strcmp(argv[i], "--cycles") == 0 && has_value) {
+      is_valid = parse_count(argv[++i], benchmark_options.cycles);
+    } else if (std::strcmp(argv[i], "--seconds") == 0 && has_value) {
+      is_valid = parse_seconds(argv[++i], benchmark_options.seconds);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+      is_valid = parse_count(argv[++i], benchmark_options.seed);
+    } else if (std::strcmp(argv[i], "--micro") == 0 && has_value) {
+      is_valid = parse_count(argv[++i], benchmark_options.micro_instructions);
+    } else if (std::strcmp(argv[i], "--config") == 0 && has_value) {
+      benchmark_options.config_file = argv[++i];
+    } else {
+      is_valid = false;
+    }
+
+    if (!is_valid) {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  // the other options only apply to the headless mode
+  if (has_benchmark_options && !is_benchmark) {
+    print_usage(argv[0]);
+    return 1;
+  }
 
   Emulator emulator;
+
+  // headless mode, run for a fixed number of cycles or seconds and report
+  if (is_benchmark) {
+    if (benchmark_options.cycles == 0 && benchmark_options.seconds <= 0.0)
+      benchmark_options.cycles = 100000;
+
+    try {
+      if (benchmark_options.micro_instructions > 0)
+        emulator.run_instruction_benchmark(benchmark_options);
+      else
+        emulator.run_benchmark(benchmark_options);
+    } catch (const std::exception &e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+
+    return 0;
+  }
+
   std::string input;
 
   while (true) {
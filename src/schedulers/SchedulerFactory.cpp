@@ -1,13 +1,19 @@
 #include "schedulers/SchedulerFactory.hpp"
 #include "schedulers/FCFSScheduler.hpp"
 #include "schedulers/RRScheduler.hpp"
+#include "schedulers/WorkStealingScheduler.hpp"
 
 std::unique_ptr<IScheduler>
-SchedulerFactory::create_scheduler(const std::string &type, int quantum) {
+SchedulerFactory::create_scheduler(const std::string &type, int quantum,
+                                   int num_cores) {
   if (type == "rr") {
     return std::make_unique<RRScheduler>(quantum);
   } else if (type == "fcfs") {
     return std::make_unique<FCFSScheduler>();
+  } else if (type == "rr-ws") {
+    return std::make_unique<WorkStealingScheduler>(num_cores, quantum, true);
+  } else if (type == "fcfs-ws") {
+    return std::make_unique<WorkStealingScheduler>(num_cores, quantum, false);
   } else {
     throw std::invalid_argument("Unknown scheduler type: " + type);
   }
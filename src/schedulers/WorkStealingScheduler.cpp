@@ -0,0 +1,143 @@
+#include "schedulers/WorkStealingScheduler.hpp"
+
+WorkStealingScheduler::WorkStealingScheduler(int num_cores, int quantum_cycles,
+                                             bool is_preemptive)
+    : quantum_cycles_(quantum_cycles), is_preemptive_(is_preemptive) {
+  run_queues_.reserve(std::max(1, num_cores));
+
+  for (int i = 0; i < std::max(1, num_cores); ++i)
+    run_queues_.push_back(std::make_unique<RunQueue>());
+}
+
+void WorkStealingScheduler::add_process(Process *process) {
+  add_process(process, false);
+}
+
+void WorkStealingScheduler::add_process(Process *process, bool is_priority) {
+  // no core affinity, spread new work round robin across the run queues
+  size_t index = next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                 run_queues_.size();
+
+  push(*run_queues_[index], process, is_priority);
+}
+
+void WorkStealingScheduler::add_process(Process *process, bool is_priority,
+                                        int core_id) {
+  if (core_id < 0 || core_id >= static_cast<int>(run_queues_.size())) {
+    add_process(process, is_priority);
+    return;
+  }
+
+  // requeue on the core the process came from to keep it local
+  push(*run_queues_[core_id], process, is_priority);
+}
+
+Process *WorkStealingScheduler::get_next_process() {
+  RunQueue *queue = busiest_queue(-1);
+
+  if (!queue)
+    return nullptr;
+
+  return dispatch(pop(*queue, true));
+}
+
+Process *WorkStealingScheduler::get_next_process(int core_id) {
+  if (core_id < 0 || core_id >= static_cast<int>(run_queues_.size()))
+    return get_next_process();
+
+  Process *process = pop(*run_queues_[core_id], false);
+
+  // local queue is empty, steal from the busiest neighbour
+  if (!process) {
+    RunQueue *victim = busiest_queue(core_id);
+
+    if (victim)
+      process = pop(*victim, true);
+  }
+
+  return dispatch(process);
+}
+
+bool WorkStealingScheduler::has_processes() const {
+  return total_size_.load(std::memory_order_acquire) > 0;
+}
+
+bool WorkStealingScheduler::is_running() const { return is_running_; }
+
+void WorkStealingScheduler::start() { is_running_ = true; }
+
+void WorkStealingScheduler::stop() { is_running_ = false; }
+
+void WorkStealingScheduler::push(RunQueue &queue, Process *process,
+                                 bool is_priority) {
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (is_priority)
+      queue.preempted.push_back(process);
+    else
+      queue.ready.push_back(process);
+  }
+
+  queue.size.fetch_add(1, std::memory_order_release);
+  total_size_.fetch_add(1, std::memory_order_release);
+}
+
+// the owning core pops the oldest work so a requeued process goes to the back
+// and the queue rotates, thieves take the newest from the other end
+Process *WorkStealingScheduler::pop(RunQueue &queue, bool is_steal) {
+  // cheap check without taking the lock
+  if (queue.size.load(std::memory_order_acquire) == 0)
+    return nullptr;
+
+  Process *process = nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    std::deque<Process *> &deque =
+        !queue.preempted.empty() ? queue.preempted : queue.ready;
+
+    if (!deque.empty() && is_steal) {
+      process = deque.back();
+      deque.pop_back();
+    } else if (!deque.empty()) {
+      process = deque.front();
+      deque.pop_front();
+    }
+  }
+
+  if (process) {
+    queue.size.fetch_sub(1, std::memory_order_release);
+    total_size_.fetch_sub(1, std::memory_order_release);
+  }
+
+  return process;
+}
+
+WorkStealingScheduler::RunQueue *
+WorkStealingScheduler::busiest_queue(int core_id) {
+  RunQueue *busiest = nullptr;
+  size_t busiest_size = 0;
+
+  for (size_t i = 0; i < run_queues_.size(); ++i) {
+    if (static_cast<int>(i) == core_id)
+      continue;
+
+    size_t size = run_queues_[i]->size.load(std::memory_order_relaxed);
+
+    if (size > busiest_size) {
+      busiest = run_queues_[i].get();
+      busiest_size = size;
+    }
+  }
+
+  return busiest;
+}
+
+Process *WorkStealingScheduler::dispatch(Process *process) {
+  if (process && is_preemptive_)
+    process->set_quantum_remaining(quantum_cycles_);
+
+  return process;
+}